@@ -14,18 +14,47 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <numeric>
 #include <random>
 #include <string>
 #include <vector>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HASHING_DEMO_HAVE_CLFLUSH 1
+#else
+#define HASHING_DEMO_HAVE_CLFLUSH 0
+#endif
+
 #include "benchmark/benchmark.h"
 
+#include "bloom_filter.h"
+#include "bucket_stats.h"
+#include "cached_hash.h"
+#include "consistent_hash.h"
+#include "count_min_sketch.h"
+#include "cuckoo_filter.h"
+#include "digest_set.h"
 #include "farmhash.h"
 #include "farmhash-direct.h"
+#include "fnv1a.h"
+#include "hash_util.h"
+#include "hyperloglog.h"
+#include "key_corpus.h"
+#include "minimal_perfect_hash.h"
 #include "n3980.h"
 #include "n3980-farmhash.h"
+#include "n3980_adapters.h"
+#include "parallel_hash.h"
+#include "pimpl.h"
+#include "rolling_hash.h"
+#include "similarity.h"
+#include "space_saving.h"
 #include "std.h"
+#include "type_invariant_farmhash.h"
 
 static const int kNumBytes = 10'000'000;
 static const std::array<unsigned char, kNumBytes>& Bytes() {
@@ -78,6 +107,20 @@ struct farmhash_hasher {
   }
 };
 
+// Hashes with hash_value(), using an N3980 HashAlgorithm adapted into a
+// HashCode.
+template <typename HashAlgorithm, typename T>
+struct adapted_algorithm_hasher {
+  typename HashAlgorithm::result_type operator()(const T& t) const {
+    using HashCode = hashing::hash_code_adapter<HashAlgorithm>;
+    typename HashCode::state_type state;
+    using std_::hash_value;
+    return typename HashCode::result_type(hash_value(HashCode(&state), t));
+  }
+};
+
+using hashing::hash_code_hasher;
+
 template <class H>
 static void BM_HashStrings(benchmark::State& state) {
   const std::array<unsigned char, kNumBytes>& bytes = Bytes();
@@ -104,6 +147,196 @@ BENCHMARK_TEMPLATE(BM_HashStrings, farmhash_hasher<string_piece>)
 BENCHMARK_TEMPLATE(BM_HashStrings, std_::uhash<hashing::n3980::farmhash>)
     ->Range(1, 1000 * 1000);
 
+BENCHMARK_TEMPLATE(BM_HashStrings,
+                   hash_code_hasher<hashing::fnv1a, string_piece>)
+    ->Range(1, 1000 * 1000);
+
+BENCHMARK_TEMPLATE(BM_HashStrings,
+                   hash_code_hasher<hashing::fnv1a_word, string_piece>)
+    ->Range(1, 1000 * 1000);
+
+BENCHMARK_TEMPLATE(BM_HashStrings,
+                   hash_code_hasher<hashing::fnv1a_4lane, string_piece>)
+    ->Range(1, 1000 * 1000);
+
+BENCHMARK_TEMPLATE(BM_HashStrings,
+                   hash_code_hasher<hashing::type_invariant_fnv1a,
+                                    string_piece>)
+    ->Range(1, 1000 * 1000);
+
+BENCHMARK_TEMPLATE(BM_HashStrings, hashing::type_invariant_hash)
+    ->Range(1, 1000 * 1000);
+
+// Cold-cache variants of BM_HashStrings. BM_HashStrings hashes
+// overlapping strings at consecutive offsets, so its input is always in
+// cache, and with a fixed length the branch predictors learn the length
+// dispatch. These modes, selected by range(0), remove each of those
+// advantages in turn:
+enum ColdMode {
+  // Strings of length range(1) at random offsets in a buffer much larger
+  // than the last-level cache. The strings cover most of the buffer, so
+  // on parts whose last-level cache is much smaller than kColdBytes, most
+  // of them miss it; the rest are cache hits by chance.
+  kRandomOffsets,
+  // Like kRandomOffsets, but with Zipfian lengths in [1, range(1)], so the
+  // length dispatch is unpredictable.
+  kMixedLengths,
+  // Like kMixedLengths, but each batch of kColdBatchSize strings is
+  // evicted from every cache level, untimed, just before it's hashed, so
+  // that even strings that happen to be cached are read from memory. Only
+  // registered where clflush is available.
+  kFlushedBatches,
+};
+
+// Larger than the last-level cache of common server parts.
+static const size_t kColdBytes = size_t(256) << 20;
+// The number of strings hashed before the sequence repeats: one per 64
+// bytes of kColdBytes. 8-byte strings touch about two thirds of the
+// buffer's cache lines (some 170 MB), 64-byte strings 86% of them, and
+// 1024-byte strings all of them; Zipfian lengths are mostly short, so
+// they're close to the 8-byte figure. The string_pieces add 64 MB, read
+// sequentially. So unless the last-level cache holds that footprint, a
+// string's lines have been evicted by the time it's hashed again.
+static const size_t kNumColdStrings = size_t(1) << 22;
+static const size_t kColdBatchSize = 256;
+
+static const std::vector<unsigned char>& ColdBytes() {
+  static const std::vector<unsigned char>* const kBytes = [] {
+    auto* bytes = new std::vector<unsigned char>(kColdBytes);
+    uint64_t x = 0;
+    for (size_t i = 0; i < kColdBytes; i += sizeof(uint64_t)) {
+      // Much faster than independent_bits_engine for this much data.
+      const uint64_t z = hashing::splitmix64(&x);
+      memcpy(bytes->data() + i, &z, sizeof(z));
+    }
+    return bytes;
+  }();
+  return *kBytes;
+}
+
+// Evicts the cache lines of [begin, end) from every cache level. This
+// costs time proportional to the strings' size, unlike sweeping a buffer
+// larger than the last-level cache.
+static void FlushStrings(const string_piece* begin, const string_piece* end) {
+#if HASHING_DEMO_HAVE_CLFLUSH
+  for (; begin != end; ++begin) {
+    const uintptr_t first = reinterpret_cast<uintptr_t>(begin->begin) & ~63;
+    for (uintptr_t line = first;
+         line < reinterpret_cast<uintptr_t>(begin->end); line += 64) {
+      _mm_clflush(reinterpret_cast<const void*>(line));
+    }
+  }
+  _mm_mfence();
+#endif
+}
+
+template <class H>
+static void BM_HashStringsCold(benchmark::State& state) {
+  const std::vector<unsigned char>& bytes = ColdBytes();
+  const ColdMode mode = static_cast<ColdMode>(state.range(0));
+  const int max_length = state.range(1);
+
+  // Precomputed, so that generating them isn't timed. They're read
+  // sequentially, which the prefetcher handles well.
+  std::default_random_engine engine;
+  std::uniform_int_distribution<size_t> offset(0, kColdBytes - max_length);
+  const hashing::zipfian_distribution zipfian_length(max_length);
+  std::vector<string_piece> strings;
+  strings.reserve(kNumColdStrings);
+  int64_t total_bytes = 0;
+  for (size_t i = 0; i < kNumColdStrings; ++i) {
+    const size_t length =
+        mode == kRandomOffsets ? max_length : 1 + zipfian_length(engine);
+    const unsigned char* begin = &bytes[offset(engine)];
+    strings.emplace_back(begin, begin + length);
+    total_bytes += length;
+  }
+
+  size_t i = 0;
+  H h;
+  while (state.KeepRunning()) {
+    // kNumColdStrings is a multiple of kColdBatchSize, so batches don't
+    // wrap.
+    if (mode == kFlushedBatches && i % kColdBatchSize == 0) {
+      state.PauseTiming();
+      FlushStrings(&strings[i], &strings[i] + kColdBatchSize);
+      state.ResumeTiming();
+    }
+    benchmark::DoNotOptimize(h(strings[i]));
+    if (++i == strings.size()) i = 0;
+  }
+  static const char* const kModeNames[] = {"random offsets", "mixed lengths",
+                                           "flushed batches"};
+  state.SetLabel(kModeNames[mode]);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          total_bytes / kNumColdStrings);
+}
+
+static void ColdArgs(benchmark::internal::Benchmark* b) {
+  for (int mode : {kRandomOffsets, kMixedLengths, kFlushedBatches}) {
+    if (mode == kFlushedBatches && !HASHING_DEMO_HAVE_CLFLUSH) continue;
+    for (int length : {8, 64, 1024}) {
+      b->ArgPair(mode, length);
+    }
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_HashStringsCold, farmhash_string_direct)
+    ->Apply(ColdArgs);
+BENCHMARK_TEMPLATE(BM_HashStringsCold, farmhash_hasher<string_piece>)
+    ->Apply(ColdArgs);
+BENCHMARK_TEMPLATE(BM_HashStringsCold, std_::uhash<hashing::n3980::farmhash>)
+    ->Apply(ColdArgs);
+BENCHMARK_TEMPLATE(BM_HashStringsCold,
+                   hash_code_hasher<hashing::fnv1a, string_piece>)
+    ->Apply(ColdArgs);
+
+// Like BM_HashStrings, but hashes the keys of a realistic corpus, selected
+// by range(0) as in hashing::benchmark_key_corpus(); see key_corpus.h.
+template <class H>
+static void BM_HashCorpus(benchmark::State& state) {
+  const std::vector<std::string> keys =
+      hashing::benchmark_key_corpus(state.range(0), 1 << 16);
+  if (keys.empty()) {
+    state.SkipWithError("HASHING_DEMO_KEY_CORPUS is not a readable file");
+    return;
+  }
+  std::vector<string_piece> pieces;
+  int64_t total_bytes = 0;
+  for (const std::string& key : keys) {
+    const auto* data = reinterpret_cast<const unsigned char*>(key.data());
+    pieces.emplace_back(data, data + key.size());
+    total_bytes += key.size();
+  }
+
+  size_t i = 0;
+  H h;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(h(pieces[i]));
+    if (++i == pieces.size()) i = 0;
+  }
+  state.SetLabel(hashing::benchmark_key_corpus_name(state.range(0)));
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          total_bytes / pieces.size());
+}
+
+// The generated corpora, and the HASHING_DEMO_KEY_CORPUS file if set.
+static void CorpusArgs(benchmark::internal::Benchmark* b) {
+  b->DenseRange(0, hashing::num_benchmark_key_corpora() - 1);
+}
+
+BENCHMARK_TEMPLATE(BM_HashCorpus, farmhash_string_direct)->Apply(CorpusArgs);
+BENCHMARK_TEMPLATE(BM_HashCorpus, farmhash_hasher<string_piece>)
+    ->Apply(CorpusArgs);
+BENCHMARK_TEMPLATE(BM_HashCorpus, std_::uhash<hashing::n3980::farmhash>)
+    ->Apply(CorpusArgs);
+BENCHMARK_TEMPLATE(BM_HashCorpus,
+                   hash_code_hasher<hashing::fnv1a, string_piece>)
+    ->Apply(CorpusArgs);
+BENCHMARK_TEMPLATE(BM_HashCorpus,
+                   hash_code_hasher<hashing::fnv1a_4lane, string_piece>)
+    ->Apply(CorpusArgs);
+
 // Based on N3980's "X", but data_ is non-contiguous, in order to exercise
 // a different part of the performance space.
 struct X {
@@ -132,15 +365,21 @@ static void BM_HashX(benchmark::State& state) {
 
   static std::default_random_engine engine;
 
-  const int max_data_size = state.range_x();
+  // range(1) selects the distribution of data_ sizes up to range(0):
+  // uniform, or Zipfian, in which small sizes dominate as in real data.
+  const int max_data_size = state.range(0);
+  const bool zipfian_sizes = state.range(1);
   std::uniform_int_distribution<std::size_t> data_size(0, max_data_size);
+  const hashing::zipfian_distribution zipfian_data_size(
+      zipfian_sizes ? max_data_size + 1 : 1);
 
   const int num_xs = kNumBytes/max_data_size;
   std::vector<X> xs(num_xs);
 
   for (X& x : xs) {
     x.date_ = {years(engine), months(engine), days(engine)};
-    x.data_.resize(data_size(engine));
+    x.data_.resize(zipfian_sizes ? zipfian_data_size(engine)
+                                 : data_size(engine));
     for (auto& p : x.data_) {
       p = {cvalue(engine), ivalue(engine)};
     }
@@ -159,10 +398,777 @@ static void BM_HashX(benchmark::State& state) {
       + cumulative_vector_size * sizeof(std::pair<int, int>));
 }
 
-BENCHMARK_TEMPLATE(BM_HashX, farmhash_hasher<X>)
-    ->Range(1, 1000 * 1000);
+static void HashXArgs(benchmark::internal::Benchmark* b) {
+  for (int zipfian_sizes = 0; zipfian_sizes <= 1; ++zipfian_sizes) {
+    for (int max_size : {1, 8, 64, 512, 4096, 32768, 262144, 1000 * 1000}) {
+      b->ArgPair(max_size, zipfian_sizes);
+    }
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_HashX, farmhash_hasher<X>)->Apply(HashXArgs);
 
 BENCHMARK_TEMPLATE(BM_HashX, std_::uhash<hashing::n3980::farmhash>)
-    ->Range(1, 1000 * 1000);
+    ->Apply(HashXArgs);
+
+BENCHMARK_TEMPLATE(BM_HashX, hash_code_hasher<hashing::fnv1a_word, X>)
+    ->Apply(HashXArgs);
+
+BENCHMARK_TEMPLATE(BM_HashX, hash_code_hasher<hashing::fnv1a_4lane, X>)
+    ->Apply(HashXArgs);
+
+// Builds a table of long string keys, and then repeatedly grows or shrinks
+// its bucket array and looks up every key, using the same key objects that
+// were inserted. Key is either std::string, which is rehashed on every
+// lookup (and on every rehash() by tables that don't store hash codes), or
+// cached_hash<std::string>, which is hashed only once.
+template <class Key>
+static void BM_RehashAndLookupStrings(benchmark::State& state) {
+  const std::array<unsigned char, kNumBytes>& bytes = Bytes();
+  const int num_keys = state.range(0);
+  const int string_size = 256;
+
+  std::vector<Key> keys;
+  keys.reserve(num_keys);
+  for (int i = 0; i < num_keys; ++i) {
+    keys.emplace_back(std::string(
+        reinterpret_cast<const char*>(&bytes[i]), string_size));
+  }
+  std_::unordered_set<Key> set(keys.begin(), keys.end());
+
+  bool grow = true;
+  while (state.KeepRunning()) {
+    set.rehash(grow ? 4 * num_keys : 0);
+    grow = !grow;
+    for (const Key& key : keys) {
+      benchmark::DoNotOptimize(set.find(key));
+    }
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          num_keys);
+}
+
+BENCHMARK_TEMPLATE(BM_RehashAndLookupStrings, std::string)
+    ->Range(8, 64 * 1024);
+
+BENCHMARK_TEMPLATE(BM_RehashAndLookupStrings,
+                   hashing::cached_hash<std::string>)
+    ->Range(8, 64 * 1024);
+
+static std::vector<uint64_t> RandomKeys(int num_keys) {
+  std::default_random_engine engine;
+  std::uniform_int_distribution<uint64_t> dist;
+  std::vector<uint64_t> keys(num_keys);
+  for (uint64_t& key : keys) {
+    key = dist(engine);
+  }
+  return keys;
+}
+
+// Measures the cost of constructing a filter for range(0) keys and inserting
+// them all.
+template <class Filter>
+static void BM_FilterBuild(benchmark::State& state) {
+  const std::vector<uint64_t> keys = RandomKeys(state.range(0));
+  while (state.KeepRunning()) {
+    Filter filter(keys.size());
+    for (uint64_t key : keys) {
+      filter.insert(key);
+    }
+    benchmark::DoNotOptimize(filter);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          keys.size());
+}
+
+BENCHMARK_TEMPLATE(BM_FilterBuild, hashing::blocked_bloom_filter<uint64_t>)
+    ->Range(1024, 4 * 1024 * 1024);
+
+BENCHMARK_TEMPLATE(BM_FilterBuild, hashing::cuckoo_filter<uint64_t>)
+    ->Range(1024, 4 * 1024 * 1024);
+
+// Measures query throughput on a filter holding range(0) keys, with half of
+// the queries for absent keys. Also reports the false-positive rate and the
+// filter size.
+template <class Filter>
+static void BM_FilterQuery(benchmark::State& state) {
+  const int num_keys = state.range(0);
+  const std::vector<uint64_t> keys = RandomKeys(2 * num_keys);
+  Filter filter(num_keys);
+  for (int i = 0; i < num_keys; ++i) {
+    filter.insert(keys[i]);
+  }
+
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(filter.possibly_contains(keys[i]));
+    i = (i + 1) % keys.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  int false_positives = 0;
+  for (int i = num_keys; i < 2 * num_keys; ++i) {
+    false_positives += filter.possibly_contains(keys[i]);
+  }
+  state.counters["fpr"] = static_cast<double>(false_positives) / num_keys;
+  state.counters["bits/key"] =
+      static_cast<double>(filter.size_in_bits()) / num_keys;
+}
+
+BENCHMARK_TEMPLATE(BM_FilterQuery, hashing::blocked_bloom_filter<uint64_t>)
+    ->Range(1024, 4 * 1024 * 1024);
+
+BENCHMARK_TEMPLATE(BM_FilterQuery, hashing::cuckoo_filter<uint64_t>)
+    ->Range(1024, 4 * 1024 * 1024);
+
+// Measures the cost of inserting range(0) distinct keys into a fresh
+// precision-14 sketch, which covers both the sparse and dense regimes.
+static void BM_HyperLogLogInsert(benchmark::State& state) {
+  const std::vector<uint64_t> keys = RandomKeys(state.range(0));
+  while (state.KeepRunning()) {
+    hashing::hyperloglog<uint64_t> sketch;
+    for (uint64_t key : keys) {
+      sketch.insert(key);
+    }
+    benchmark::DoNotOptimize(sketch);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          keys.size());
+}
+
+BENCHMARK(BM_HyperLogLogInsert)->Range(64, 4 * 1024 * 1024);
+
+// Measures the cost of merging a sketch of range(0) keys into another
+// sketch of the same size. Small sizes are sparse, large ones dense.
+static void BM_HyperLogLogMerge(benchmark::State& state) {
+  const int num_keys = state.range(0);
+  const std::vector<uint64_t> keys = RandomKeys(2 * num_keys);
+  hashing::hyperloglog<uint64_t> a, b;
+  for (int i = 0; i < num_keys; ++i) {
+    a.insert(keys[i]);
+    b.insert(keys[num_keys + i]);
+  }
+  while (state.KeepRunning()) {
+    hashing::hyperloglog<uint64_t> merged = a;
+    merged.merge(b);
+    benchmark::DoNotOptimize(merged);
+  }
+  state.counters["serialized_bytes"] = a.serialize().size();
+}
+
+BENCHMARK(BM_HyperLogLogMerge)->Range(64, 1024 * 1024);
+
+// Returns 'length' keys drawn from range(0) distinct values with a Zipfian
+// (s = 1) popularity distribution, which is what frequency sketches are
+// typically fed.
+static std::vector<uint64_t> ZipfianKeys(int num_distinct, int length) {
+  std::vector<double> weights(num_distinct);
+  for (int i = 0; i < num_distinct; ++i) {
+    weights[i] = 1.0 / (i + 1);
+  }
+  std::discrete_distribution<int> dist(weights.begin(), weights.end());
+  const std::vector<uint64_t> values = RandomKeys(num_distinct);
+  std::default_random_engine engine;
+  std::vector<uint64_t> keys(length);
+  for (uint64_t& key : keys) {
+    key = values[dist(engine)];
+  }
+  return keys;
+}
+
+template <hashing::count_min_sketch<uint64_t>::update_policy policy>
+static void BM_CountMinSketchAdd(benchmark::State& state) {
+  const std::vector<uint64_t> keys = ZipfianKeys(state.range(0), 1 << 20);
+  hashing::count_min_sketch<uint64_t> sketch(1 << 14, 4, policy);
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    sketch.add(keys[i]);
+    i = (i + 1) % keys.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(
+    BM_CountMinSketchAdd,
+    hashing::count_min_sketch<uint64_t>::update_policy::standard)
+    ->Range(1024, 1024 * 1024);
+
+BENCHMARK_TEMPLATE(
+    BM_CountMinSketchAdd,
+    hashing::count_min_sketch<uint64_t>::update_policy::conservative)
+    ->Range(1024, 1024 * 1024);
+
+// range(0) is the number of distinct keys, range(1) the number of keys
+// tracked.
+static void BM_SpaceSavingAdd(benchmark::State& state) {
+  const std::vector<uint64_t> keys = ZipfianKeys(state.range(0), 1 << 20);
+  hashing::space_saving<uint64_t> top(state.range(1));
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    top.add(keys[i]);
+    i = (i + 1) % keys.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_SpaceSavingAdd)
+    ->RangeMultiplier(32)->Ranges({{1024, 1024 * 1024}, {16, 1024}});
+
+// The following benchmarks measure the time to route one key to one of
+// range(0) shards.
+static void BM_JumpConsistentHash(benchmark::State& state) {
+  const std::vector<uint64_t> keys = RandomKeys(1 << 16);
+  const int32_t num_shards = state.range(0);
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(hashing::jump_route(keys[i], num_shards));
+    i = (i + 1) % keys.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_JumpConsistentHash)->Arg(10)->Arg(100)->Arg(1000);
+
+// range(1) selects equal weights (0), which allows integer comparison of
+// scores, or distinct weights (1).
+static void BM_RendezvousHash(benchmark::State& state) {
+  const std::vector<uint64_t> keys = RandomKeys(1 << 16);
+  hashing::rendezvous_hash<int> router;
+  for (int node = 0; node < state.range(0); ++node) {
+    router.add_node(node, state.range(1) ? 1.0 + node % 3 : 1.0);
+  }
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(router.route(keys[i]));
+    i = (i + 1) % keys.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_RendezvousHash)
+    ->ArgPair(10, 0)->ArgPair(100, 0)->ArgPair(1000, 0)
+    ->ArgPair(10, 1)->ArgPair(100, 1)->ArgPair(1000, 1);
+
+// Measures content-defined chunking of Bytes() with an average chunk size
+// of range(0) bytes, with cut-point detection alone and with each chunk
+// also fingerprinted with hashing::farmhash.
+static void BM_ContentDefinedChunking(benchmark::State& state) {
+  const std::array<unsigned char, kNumBytes>& bytes = Bytes();
+  const size_t avg_size = state.range(0);
+  hashing::content_defined_chunker chunker(avg_size / 4, avg_size,
+                                           avg_size * 8);
+  while (state.KeepRunning()) {
+    size_t num_chunks = 0;
+    chunker.for_each_chunk(
+        bytes.data(), bytes.data() + bytes.size(),
+        [&](const unsigned char*, const unsigned char*) { ++num_chunks; });
+    benchmark::DoNotOptimize(num_chunks);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          bytes.size());
+}
+
+BENCHMARK(BM_ContentDefinedChunking)->Arg(1024)->Arg(8 * 1024)
+    ->Arg(64 * 1024);
+
+static void BM_ContentDefinedChunkingWithFingerprints(
+    benchmark::State& state) {
+  const std::array<unsigned char, kNumBytes>& bytes = Bytes();
+  const size_t avg_size = state.range(0);
+  hashing::content_defined_chunker chunker(avg_size / 4, avg_size,
+                                           avg_size * 8);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(
+        chunker.chunks(bytes.data(), bytes.data() + bytes.size()));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          bytes.size());
+}
+
+BENCHMARK(BM_ContentDefinedChunkingWithFingerprints)->Arg(1024)
+    ->Arg(8 * 1024)->Arg(64 * 1024);
+
+template <typename Key>
+static std_::unordered_set<Key> RandomSet(int size);
+
+template <>
+std_::unordered_set<uint64_t> RandomSet<uint64_t>(int size) {
+  const std::vector<uint64_t> keys = RandomKeys(size);
+  return std_::unordered_set<uint64_t>(keys.begin(), keys.end());
+}
+
+template <>
+std_::unordered_set<std::string> RandomSet<std::string>(int size) {
+  std_::unordered_set<std::string> set;
+  for (uint64_t key : RandomKeys(size)) {
+    set.insert(std::to_string(key));
+  }
+  return set;
+}
+
+// The following benchmarks hash an unordered set of range(0) elements,
+// using the order-independent hash_value(), using it on range(1) threads,
+// and (as a baseline) by copying and sorting the elements and hashing
+// the result.
+template <typename Key>
+static void BM_HashUnorderedSet(benchmark::State& state) {
+  const std_::unordered_set<Key> set = RandomSet<Key>(state.range(0));
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(std_::hash<std_::unordered_set<Key>>{}(set));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          set.size());
+}
+
+BENCHMARK_TEMPLATE(BM_HashUnorderedSet, uint64_t)->Range(1024, 1024 * 1024);
+BENCHMARK_TEMPLATE(BM_HashUnorderedSet, std::string)
+    ->Range(1024, 1024 * 1024);
+
+template <typename Key>
+static void BM_HashUnorderedSetParallel(benchmark::State& state) {
+  const std_::unordered_set<Key> set = RandomSet<Key>(state.range(0));
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(
+        hashing::parallel_unordered_hash(set, state.range(1)));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          set.size());
+}
+
+BENCHMARK_TEMPLATE(BM_HashUnorderedSetParallel, uint64_t)
+    ->RangeMultiplier(32)->Ranges({{1024, 1024 * 1024}, {2, 8}})
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_HashUnorderedSetParallel, std::string)
+    ->RangeMultiplier(32)->Ranges({{1024, 1024 * 1024}, {2, 8}})
+    ->UseRealTime();
+
+template <typename Key>
+static void BM_HashUnorderedSetBySorting(benchmark::State& state) {
+  const std_::unordered_set<Key> set = RandomSet<Key>(state.range(0));
+  while (state.KeepRunning()) {
+    std::vector<Key> sorted(set.begin(), set.end());
+    std::sort(sorted.begin(), sorted.end());
+    benchmark::DoNotOptimize(std_::hash<std::vector<Key>>{}(sorted));
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          set.size());
+}
+
+BENCHMARK_TEMPLATE(BM_HashUnorderedSetBySorting, uint64_t)
+    ->Range(1024, 1024 * 1024);
+BENCHMARK_TEMPLATE(BM_HashUnorderedSetBySorting, std::string)
+    ->Range(1024, 1024 * 1024);
+
+// Measures the cost of a mutation (an insert of a new key, and an erase of
+// an old one) on a set of range(0) strings, to show the overhead of
+// maintaining a digest.
+template <typename Set>
+static void BM_SetMutation(benchmark::State& state) {
+  const int size = state.range(0);
+  std::vector<std::string> keys;
+  for (uint64_t key : RandomKeys(2 * size)) {
+    keys.push_back(std::to_string(key));
+  }
+  Set set;
+  for (int i = 0; i < size; ++i) {
+    set.insert(keys[i]);
+  }
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    set.insert(keys[(i + size) % keys.size()]);
+    set.erase(keys[i]);
+    i = (i + 1) % keys.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_SetMutation, std_::unordered_set<std::string>)
+    ->Range(1024, 1024 * 1024);
+BENCHMARK_TEMPLATE(BM_SetMutation, hashing::digest_set<std::string>)
+    ->Range(1024, 1024 * 1024);
+
+// Compares the cost of computing a set's hash from scratch with reading
+// the digest of a digest_set.
+template <typename Set>
+static void BM_SetHash(benchmark::State& state) {
+  Set set;
+  for (uint64_t key : RandomKeys(state.range(0))) {
+    set.insert(std::to_string(key));
+  }
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(std_::hash<Set>{}(set));
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_SetHash, std_::unordered_set<std::string>)
+    ->Range(1024, 1024 * 1024);
+BENCHMARK_TEMPLATE(BM_SetHash, hashing::digest_set<std::string>)
+    ->Range(1024, 1024 * 1024);
+
+// Measures the cost of building a minimal perfect hash function for
+// range(0) keys with range(1) threads, and reports its size.
+static void BM_MinimalPerfectHashBuild(benchmark::State& state) {
+  const std::vector<uint64_t> keys = RandomKeys(state.range(0));
+  hashing::minimal_perfect_hash<uint64_t> mphf;
+  while (state.KeepRunning()) {
+    mphf.build(keys.begin(), keys.end(), 2.0, state.range(1));
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+  state.counters["bits/key"] = double(mphf.size_in_bits()) / keys.size();
+  state.counters["levels"] = mphf.num_levels();
+}
+
+BENCHMARK(BM_MinimalPerfectHashBuild)
+    ->RangeMultiplier(16)
+    ->Ranges({{1 << 16, 1 << 24}, {1, 8}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Compares lookups of random members of a set of range(0) keys in a
+// minimal perfect hash function and in an unordered_set.
+static void BM_MinimalPerfectHashLookup(benchmark::State& state) {
+  const std::vector<uint64_t> keys = RandomKeys(state.range(0));
+  hashing::minimal_perfect_hash<uint64_t> mphf;
+  mphf.build(keys.begin(), keys.end());
+  std::vector<uint64_t> probes(keys);
+  std::shuffle(probes.begin(), probes.end(), std::default_random_engine());
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(mphf(probes[i]));
+    if (++i == probes.size()) i = 0;
+  }
+  state.counters["bits/key"] = double(mphf.size_in_bits()) / keys.size();
+}
+
+BENCHMARK(BM_MinimalPerfectHashLookup)->Range(1 << 16, 1 << 24);
+
+static void BM_UnorderedSetLookup(benchmark::State& state) {
+  const std::vector<uint64_t> keys = RandomKeys(state.range(0));
+  std_::unordered_set<uint64_t> set(keys.begin(), keys.end());
+  std::vector<uint64_t> probes(keys);
+  std::shuffle(probes.begin(), probes.end(), std::default_random_engine());
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(set.find(probes[i]));
+    if (++i == probes.size()) i = 0;
+  }
+}
+
+BENCHMARK(BM_UnorderedSetLookup)->Range(1 << 16, 1 << 24);
+
+// Returns a document of 'num_tokens' words drawn from a Zipfian
+// distribution over a 50,000 word vocabulary, roughly like English text.
+static std::vector<std::string> RandomDocument(int num_tokens) {
+  std::vector<std::string> words;
+  for (uint64_t rank : ZipfianKeys(50000, num_tokens)) {
+    words.push_back("w" + std::to_string(rank));
+  }
+  return words;
+}
+
+// Measures the cost of the MinHash signature with range(1) hash functions
+// of a document of range(0) tokens.
+static void BM_MinHashSignature(benchmark::State& state) {
+  const std::vector<std::string> document = RandomDocument(state.range(0));
+  hashing::minhash<std::string> mh(state.range(1));
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(mh.signature(document));
+  }
+  state.SetItemsProcessed(state.iterations() * document.size());
+  state.counters["signatures/s"] = benchmark::Counter(
+      state.iterations(), benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_MinHashSignature)->Ranges({{100, 10000}, {64, 256}});
+
+static void BM_SimHash(benchmark::State& state) {
+  const std::vector<std::string> document = RandomDocument(state.range(0));
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(hashing::simhash(document.begin(),
+                                              document.end()));
+  }
+  state.SetItemsProcessed(state.iterations() * document.size());
+  state.counters["signatures/s"] = benchmark::Counter(
+      state.iterations(), benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_SimHash)->Range(100, 10000);
+
+// Measures candidate retrieval from an LSH index of range(0) documents
+// with 128-value signatures, split into 32 bands of 4.
+static void BM_LshQuery(benchmark::State& state) {
+  hashing::minhash<std::string> mh(128);
+  hashing::lsh_index<int> index(32, 4);
+  const std::vector<std::string> corpus = RandomDocument(100 * state.range(0));
+  std::vector<std::vector<uint64_t>> signatures;
+  for (int doc = 0; doc < state.range(0); ++doc) {
+    signatures.push_back(mh.signature(corpus.begin() + doc * 100,
+                                      corpus.begin() + (doc + 1) * 100));
+    index.insert(doc, signatures.back());
+  }
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(index.query(signatures[i]));
+    if (++i == signatures.size()) i = 0;
+  }
+}
+
+BENCHMARK(BM_LshQuery)->Range(1000, 100000);
+
+// Has the same members and hash_value() as Impl in pimpl.cc, but hashes
+// them inline rather than through type_erased_hash_code.
+struct EquivalentToPimpl {
+  std::vector<int> v_ = {1, 2, 3};
+  std::string s_ = "abc";
+
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode hash_code, const EquivalentToPimpl& e) {
+    return hash_combine(std::move(hash_code), e.v_, e.s_);
+  }
+};
+
+// A HashCode that counts the byte ranges mixed into it. For a Pimpl'd
+// type, that's the number of indirect calls made by type_erased_hash_code.
+class range_counter {
+  size_t count_ = 0;
+
+ public:
+  using result_type = size_t;
+
+  template <typename T, typename... Ts>
+  friend range_counter hash_combine(range_counter hash_code, const T& value,
+                                    const Ts&... values) {
+    return hash_combine(
+        std_::simple_hash_combine(hash_code, value), values...);
+  }
+
+  friend range_counter hash_combine(range_counter hash_code) {
+    return hash_code;
+  }
+
+  template <typename InputIterator>
+  friend range_counter hash_combine_range(
+      range_counter hash_code, InputIterator begin, InputIterator end) {
+    return std_::simple_hash_combine_range(hash_code, begin, end);
+  }
+
+  friend range_counter hash_combine_range(
+      range_counter hash_code, const unsigned char*, const unsigned char*) {
+    ++hash_code.count_;
+    return hash_code;
+  }
+
+  explicit operator result_type() && { return count_; }
+};
+
+// Measures the cost of hashing a Pimpl'd type, or its inline equivalent,
+// with H, and reports how many byte ranges reach the underlying HashCode.
+template <class T, class H>
+static void BM_HashPimpl(benchmark::State& state) {
+  const T value;
+  H h;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(h(value));
+  }
+  using std_::hash_value;
+  state.counters["ranges/hash"] =
+      double(range_counter::result_type(hash_value(range_counter(), value)));
+}
+
+BENCHMARK_TEMPLATE(BM_HashPimpl, EquivalentToPimpl,
+                   farmhash_hasher<EquivalentToPimpl>);
+BENCHMARK_TEMPLATE(BM_HashPimpl, Pimpl, farmhash_hasher<Pimpl>);
+BENCHMARK_TEMPLATE(BM_HashPimpl, WideFields, farmhash_hasher<WideFields>);
+BENCHMARK_TEMPLATE(BM_HashPimpl, WidePimpl, farmhash_hasher<WidePimpl>);
+
+// The default path: std_::hash uses hashing::farmhash, so it calls the
+// out-of-line hash_value() directly, without type erasure.
+BENCHMARK_TEMPLATE(BM_HashPimpl, Pimpl, std_::hash<Pimpl>);
+BENCHMARK_TEMPLATE(BM_HashPimpl, WidePimpl, std_::hash<WidePimpl>);
+
+// Measures the throughput of hashing a vector of range(0) Ints, which
+// type-invariant HashCodes must widen to 64 bits.
+template <class Int, class H>
+static void BM_HashIntVector(benchmark::State& state) {
+  std::vector<Int> ints(state.range(0));
+  std::iota(ints.begin(), ints.end(), Int(0));
+  H h;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(h(ints));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          ints.size() * sizeof(Int));
+}
+
+BENCHMARK_TEMPLATE(BM_HashIntVector, int, farmhash_hasher<std::vector<int>>)
+    ->Range(1, 64 * 1024);
+BENCHMARK_TEMPLATE(BM_HashIntVector, int,
+                   hash_code_hasher<hashing::type_invariant_fnv1a,
+                                    std::vector<int>>)
+    ->Range(1, 64 * 1024);
+BENCHMARK_TEMPLATE(BM_HashIntVector, int, hashing::type_invariant_hash)
+    ->Range(1, 64 * 1024);
+BENCHMARK_TEMPLATE(BM_HashIntVector, long, hashing::type_invariant_hash)
+    ->Range(1, 64 * 1024);
+
+// A matrix of key shapes, each hashed by farmhash-direct (where the key is
+// a single contiguous byte range), by hashing::farmhash via hash_value(),
+// and by n3980::farmhash via hash_append().
+
+// Has padding between 'tag' and 'value', so it can't be hashed as bytes.
+struct PaddedKey {
+  char tag;
+  int64_t value;
+  std::string name;
+};
+
+template <typename HashCode>
+HashCode hash_value(HashCode code, const PaddedKey& key) {
+  return hash_combine(std::move(code), key.tag, key.value, key.name);
+}
+
+template <typename HashAlgorithm>
+void hash_append(HashAlgorithm& h, const PaddedKey& key) {
+  using std_::hash_append;
+  hash_append(h, key.tag, key.value, key.name);
+}
+
+// Returns 1024 keys of the given shape, with sizes controlled by 'size'.
+template <typename T>
+std::vector<T> MakeShapes(int size);
+
+template <>
+std::vector<uint64_t> MakeShapes<uint64_t>(int) {
+  std::vector<uint64_t> keys(1024);
+  std::iota(keys.begin(), keys.end(), uint64_t{0x9e3779b97f4a7c15ULL});
+  return keys;
+}
+
+template <>
+std::vector<std::string> MakeShapes<std::string>(int size) {
+  const std::array<unsigned char, kNumBytes>& bytes = Bytes();
+  std::vector<std::string> keys(1024);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    const size_t offset = (i * 997) % (kNumBytes - size);
+    keys[i].assign(&bytes[offset], &bytes[offset + size]);
+  }
+  return keys;
+}
+
+template <>
+std::vector<PaddedKey> MakeShapes<PaddedKey>(int size) {
+  std::vector<std::string> names = MakeShapes<std::string>(size);
+  std::vector<PaddedKey> keys(names.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = {char(i), int64_t(i) * 31, std::move(names[i])};
+  }
+  return keys;
+}
+
+template <>
+std::vector<std::vector<std::vector<int>>>
+MakeShapes<std::vector<std::vector<int>>>(int size) {
+  std::vector<std::vector<std::vector<int>>> keys(1024);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i].resize(size);
+    for (size_t j = 0; j < keys[i].size(); ++j) {
+      keys[i][j].assign(j % 4 + 1, int(i + j));
+    }
+  }
+  return keys;
+}
+
+// Hashes a uint64_t or std::string with farmhash-direct.
+struct farmhash_shape_direct {
+  size_t operator()(uint64_t value) const {
+    return hashing::direct::farmhash::Hash64(
+        reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+  size_t operator()(const std::string& s) const {
+    return hashing::direct::farmhash::Hash64(s.data(), s.size());
+  }
+};
+
+template <class T, class H>
+static void BM_HashShape(benchmark::State& state) {
+  const std::vector<T> keys = MakeShapes<T>(state.range(0));
+  size_t i = 0;
+  H h;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(h(keys[i]));
+    i = (i + 1) % keys.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+using NestedVector = std::vector<std::vector<int>>;
+
+BENCHMARK_TEMPLATE(BM_HashShape, uint64_t, farmhash_shape_direct)->Arg(0);
+BENCHMARK_TEMPLATE(BM_HashShape, uint64_t, farmhash_hasher<uint64_t>)->Arg(0);
+BENCHMARK_TEMPLATE(BM_HashShape, uint64_t,
+                   std_::uhash<hashing::n3980::farmhash>)->Arg(0);
+
+BENCHMARK_TEMPLATE(BM_HashShape, std::string, farmhash_shape_direct)
+    ->Range(1, 4096);
+BENCHMARK_TEMPLATE(BM_HashShape, std::string, farmhash_hasher<std::string>)
+    ->Range(1, 4096);
+BENCHMARK_TEMPLATE(BM_HashShape, std::string,
+                   std_::uhash<hashing::n3980::farmhash>)
+    ->Range(1, 4096);
+
+BENCHMARK_TEMPLATE(BM_HashShape, PaddedKey, farmhash_hasher<PaddedKey>)
+    ->Range(1, 4096);
+BENCHMARK_TEMPLATE(BM_HashShape, PaddedKey,
+                   std_::uhash<hashing::n3980::farmhash>)
+    ->Range(1, 4096);
+
+BENCHMARK_TEMPLATE(BM_HashShape, NestedVector, farmhash_hasher<NestedVector>)
+    ->Range(1, 256);
+BENCHMARK_TEMPLATE(BM_HashShape, NestedVector,
+                   std_::uhash<hashing::n3980::farmhash>)
+    ->Range(1, 256);
+
+// The adapters should cost nothing over the kernels they wrap, so in an
+// optimized build each of these should match the corresponding
+// farmhash_hasher or n3980::farmhash row above.
+using AdaptedFarmhash =
+    std_::uhash<hashing::hash_algorithm_adapter<hashing::farmhash>>;
+
+BENCHMARK_TEMPLATE(BM_HashShape, uint64_t,
+                   adapted_algorithm_hasher<hashing::n3980::farmhash,
+                                            uint64_t>)->Arg(0);
+BENCHMARK_TEMPLATE(BM_HashShape, uint64_t, AdaptedFarmhash)->Arg(0);
+
+BENCHMARK_TEMPLATE(BM_HashShape, std::string,
+                   adapted_algorithm_hasher<hashing::n3980::farmhash,
+                                            std::string>)
+    ->Range(1, 4096);
+BENCHMARK_TEMPLATE(BM_HashShape, std::string, AdaptedFarmhash)
+    ->Range(1, 4096);
+
+BENCHMARK_TEMPLATE(BM_HashShape, PaddedKey,
+                   adapted_algorithm_hasher<hashing::n3980::farmhash,
+                                            PaddedKey>)
+    ->Range(1, 4096);
+BENCHMARK_TEMPLATE(BM_HashShape, PaddedKey, AdaptedFarmhash)
+    ->Range(1, 4096);
+
+// Measures the cost of computing bucket statistics for a table of range(0)
+// ints, over every bucket or over 1000 sampled buckets.
+template <bool kSampled>
+static void BM_BucketStats(benchmark::State& state) {
+  std_::unordered_set<int> set;
+  for (int i = 0; i < state.range(0); ++i) set.insert(i);
+  while (state.KeepRunning()) {
+    if (kSampled) {
+      benchmark::DoNotOptimize(hashing::sample_bucket_stats(set, 1000));
+    } else {
+      benchmark::DoNotOptimize(hashing::compute_bucket_stats(set));
+    }
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_BucketStats, false)->Range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(BM_BucketStats, true)->Range(1 << 10, 1 << 20);
 
 BENCHMARK_MAIN();
@@ -0,0 +1,134 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Blocked Bloom filter for any type that std_::hash supports. Not part of
+// this proposal; it's an example of a data structure that gets its hashing
+// "for free" from the hash_value() extension point.
+
+#ifndef HASHING_DEMO_BLOOM_FILTER_H
+#define HASHING_DEMO_BLOOM_FILTER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "std.h"
+
+namespace hashing {
+
+// A Bloom filter in which all k probes for a given key land in the same
+// 64-byte block, so that insert() and possibly_contains() each touch a
+// single cache line.
+//
+// The key is hashed exactly once, by Hash. The upper 32 bits of the hash
+// select the block, and the k bit positions within the block are derived
+// from the lower and upper halves by double hashing
+// (h1 + i * h2, i = 0..k-1), following Kirsch and Mitzenmacher.
+template <typename T, typename Hash = std_::hash<T>>
+class blocked_bloom_filter {
+ public:
+  static constexpr size_t kBitsPerBlock = 512;
+  static constexpr size_t kWordsPerBlock = kBitsPerBlock / 64;
+
+  // Constructs a filter sized for 'expected_elements' keys, using
+  // 'bits_per_element' bits for each. The number of probes is chosen to
+  // minimize the false-positive rate for that load.
+  explicit blocked_bloom_filter(size_t expected_elements,
+                                double bits_per_element = 10.0,
+                                Hash hash = Hash())
+      : blocks_(std::max<size_t>(
+            1, static_cast<size_t>(std::ceil(expected_elements *
+                                             bits_per_element /
+                                             kBitsPerBlock)))),
+        num_probes_(std::min(
+            16, std::max(1, static_cast<int>(std::lround(
+                                bits_per_element * 0.6931471805599453))))),
+        hash_(std::move(hash)) {}
+
+  void insert(const T& key) { insert_hash(hash_(key)); }
+
+  // Returns false if 'key' has definitely not been inserted, and true if it
+  // probably has.
+  bool possibly_contains(const T& key) const {
+    return possibly_contains_hash(hash_(key));
+  }
+
+  // Variants of the above that take a precomputed hash value, for callers
+  // that already have one (e.g. from cached_hash).
+  void insert_hash(size_t hash) {
+    uint64_t mask[kWordsPerBlock];
+    make_mask(hash, mask);
+    block& b = blocks_[block_index(hash)];
+    for (size_t i = 0; i < kWordsPerBlock; ++i) {
+      b.words[i] |= mask[i];
+    }
+  }
+
+  bool possibly_contains_hash(size_t hash) const {
+    uint64_t mask[kWordsPerBlock];
+    make_mask(hash, mask);
+    const block& b = blocks_[block_index(hash)];
+    // Accumulate without early exit, so that the compiler can process the
+    // whole block with a few vector instructions.
+    uint64_t missing = 0;
+    for (size_t i = 0; i < kWordsPerBlock; ++i) {
+      missing |= mask[i] & ~b.words[i];
+    }
+    return missing == 0;
+  }
+
+  // Merges the contents of 'other' into this filter. Both filters must have
+  // been constructed with the same parameters.
+  void merge(const blocked_bloom_filter& other) {
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+      for (size_t j = 0; j < kWordsPerBlock; ++j) {
+        blocks_[i].words[j] |= other.blocks_[i].words[j];
+      }
+    }
+  }
+
+  int num_probes() const { return num_probes_; }
+  size_t size_in_bits() const { return blocks_.size() * kBitsPerBlock; }
+
+ private:
+  struct alignas(64) block {
+    uint64_t words[kWordsPerBlock] = {};
+  };
+
+  size_t block_index(size_t hash) const {
+    // Maps the upper 32 bits onto [0, blocks_.size()) without a division.
+    return static_cast<size_t>(
+        (static_cast<uint64_t>(hash >> 32) * blocks_.size()) >> 32);
+  }
+
+  void make_mask(size_t hash, uint64_t (&mask)[kWordsPerBlock]) const {
+    const uint32_t h1 = static_cast<uint32_t>(hash);
+    const uint32_t h2 = static_cast<uint32_t>(hash >> 32) | 1;
+    std::fill(mask, mask + kWordsPerBlock, 0);
+    for (int i = 0; i < num_probes_; ++i) {
+      const uint32_t bit = (h1 + i * h2) % kBitsPerBlock;
+      mask[bit / 64] |= uint64_t{1} << (bit % 64);
+    }
+  }
+
+  std::vector<block> blocks_;
+  int num_probes_;
+  Hash hash_;
+};
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_BLOOM_FILTER_H
@@ -0,0 +1,185 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Statistics on the distribution of a hash table's elements among its
+// buckets, for detecting poor hash_value() implementations. Not part of
+// this proposal.
+
+#ifndef HASHING_DEMO_BUCKET_STATS_H
+#define HASHING_DEMO_BUCKET_STATS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "hash_util.h"
+
+namespace hashing {
+
+// Summary of how a table's elements are distributed among its buckets.
+// For a table with separate chaining, such as std_::unordered_set, a
+// bucket's "chain" is its elements; for an open-addressing table, it can be
+// the probe length of each slot's element, in which case the occupancy
+// histogram is a probe-length histogram.
+struct bucket_stats {
+  // Number of occupancy histogram entries; the last counts all buckets
+  // with at least kMaxOccupancy elements.
+  static constexpr size_t kMaxOccupancy = 16;
+
+  size_t size = 0;
+  size_t bucket_count = 0;
+  // Number of buckets examined; less than bucket_count when sampled.
+  size_t buckets_examined = 0;
+  // Number of elements in the examined buckets.
+  size_t elements_examined = 0;
+
+  // occupancy[k] is the number of examined buckets with k elements.
+  std::vector<size_t> occupancy = std::vector<size_t>(kMaxOccupancy + 1);
+  size_t max_chain = 0;
+  // Sum of the squares of the examined buckets' sizes.
+  uint64_t sum_chain_squares = 0;
+
+  // Pearson's chi-squared statistic of the examined buckets' sizes,
+  // against a uniform distribution of the elements among all buckets.
+  double chi_squared = 0;
+
+  double load_factor() const {
+    return bucket_count == 0 ? 0 : double(size) / bucket_count;
+  }
+
+  // Mean number of elements in the non-empty examined buckets.
+  double mean_chain() const {
+    const size_t nonempty = buckets_examined - occupancy[0];
+    return nonempty == 0 ? 0 : double(elements_examined) / nonempty;
+  }
+
+  // Mean number of elements a successful lookup compares, i.e. a chain
+  // length weighted by the number of elements in the chain.
+  double mean_successful_probe() const {
+    return elements_examined == 0
+               ? 0
+               : double(sum_chain_squares + elements_examined) /
+                     (2 * elements_examined);
+  }
+
+  // Fraction of the examined buckets that are empty, and the fraction
+  // expected of a uniform hash, e^-load_factor() for large tables. An excess
+  // of empty buckets is the easiest sign of clustering to detect by
+  // sampling, since the few heavily-loaded buckets may not be sampled.
+  double empty_fraction() const {
+    return buckets_examined == 0 ? 0 : double(occupancy[0]) / buckets_examined;
+  }
+  double expected_empty_fraction() const { return std::exp(-load_factor()); }
+
+  // The chi-squared statistic divided by its degrees of freedom. A uniform
+  // hash gives about 1, and substantially larger values mean that elements
+  // cluster.
+  double uniformity() const {
+    return buckets_examined <= 1 ? 0 : chi_squared / (buckets_examined - 1);
+  }
+
+  std::string to_string() const {
+    std::ostringstream out;
+    out << "size=" << size << " buckets=" << bucket_count
+        << " load_factor=" << load_factor() << " examined=" << buckets_examined
+        << " max_chain=" << max_chain << " mean_chain=" << mean_chain()
+        << " mean_successful_probe=" << mean_successful_probe()
+        << " chi_squared=" << chi_squared << " uniformity=" << uniformity()
+        << " empty_fraction=" << empty_fraction()
+        << " expected_empty_fraction=" << expected_empty_fraction()
+        << "\noccupancy:";
+    for (size_t k = 0; k < occupancy.size(); ++k) {
+      if (occupancy[k] == 0) continue;
+      out << " " << k << (k == kMaxOccupancy ? "+:" : ":") << occupancy[k];
+    }
+    return out.str();
+  }
+};
+
+// Accumulates a bucket_stats from the sizes of the buckets of any kind of
+// table, one bucket at a time.
+class bucket_stats_accumulator {
+ public:
+  bucket_stats_accumulator(size_t size, size_t bucket_count) {
+    stats_.size = size;
+    stats_.bucket_count = bucket_count;
+  }
+
+  void add_bucket(size_t chain) {
+    ++stats_.buckets_examined;
+    stats_.elements_examined += chain;
+    ++stats_.occupancy[std::min(chain, bucket_stats::kMaxOccupancy)];
+    stats_.max_chain = std::max(stats_.max_chain, chain);
+    stats_.sum_chain_squares += uint64_t(chain) * chain;
+  }
+
+  bucket_stats finish() const {
+    bucket_stats result = stats_;
+    // sum((n_i - m)^2 / m) = sum(n_i^2) / m - 2 * sum(n_i) + k * m, where
+    // m is the expected bucket size and k the number of buckets examined.
+    const double m = result.load_factor();
+    if (m > 0) {
+      result.chi_squared = result.sum_chain_squares / m -
+                           2.0 * result.elements_examined +
+                           result.buckets_examined * m;
+    }
+    return result;
+  }
+
+ private:
+  bucket_stats stats_;
+};
+
+// Returns the bucket statistics of 'table', which must provide size(),
+// bucket_count() and bucket_size(), like the standard unordered
+// containers. This examines every bucket, so it takes O(bucket_count())
+// time.
+template <typename Table>
+bucket_stats compute_bucket_stats(const Table& table) {
+  bucket_stats_accumulator accumulator(table.size(), table.bucket_count());
+  for (size_t b = 0; b < table.bucket_count(); ++b) {
+    accumulator.add_bucket(table.bucket_size(b));
+  }
+  return accumulator.finish();
+}
+
+// Like compute_bucket_stats(), but examines only 'num_samples' buckets
+// chosen pseudo-randomly (with replacement) from 'seed', so that its cost
+// doesn't grow with the table, and it can be run periodically on live
+// tables. size and load factor are exact; the other statistics describe
+// the sampled buckets. Clustering shows up as a high uniformity(), or, if
+// the heavily-loaded buckets are too few to be sampled, as an
+// empty_fraction() well above expected_empty_fraction(), even with a few
+// hundred samples.
+template <typename Table>
+bucket_stats sample_bucket_stats(const Table& table, size_t num_samples,
+                                 uint64_t seed = 0) {
+  const size_t bucket_count = table.bucket_count();
+  bucket_stats_accumulator accumulator(table.size(), bucket_count);
+  if (bucket_count == 0) return accumulator.finish();
+  uint64_t x = seed;
+  for (size_t i = 0; i < num_samples; ++i) {
+    const uint64_t z = splitmix64(&x);
+    accumulator.add_bucket(table.bucket_size(z % bucket_count));
+  }
+  return accumulator.finish();
+}
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_BUCKET_STATS_H
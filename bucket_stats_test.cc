@@ -0,0 +1,105 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bucket_stats.h"
+
+#include <cstddef>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "std.h"
+
+namespace {
+
+using ::hashing::bucket_stats;
+using ::hashing::compute_bucket_stats;
+using ::hashing::sample_bucket_stats;
+
+// Maps every key to one of 'kNumHashes' values.
+struct ClusteringHash {
+  static constexpr size_t kNumHashes = 8;
+  size_t operator()(int i) const { return i % kNumHashes; }
+};
+
+TEST(BucketStatsTest, EmptyTable) {
+  std_::unordered_set<int> set;
+  const bucket_stats stats = compute_bucket_stats(set);
+  EXPECT_EQ(0u, stats.size);
+  EXPECT_EQ(0u, stats.max_chain);
+  EXPECT_EQ(0, stats.chi_squared);
+  EXPECT_EQ(0, stats.mean_chain());
+}
+
+TEST(BucketStatsTest, GoodHashIsUniform) {
+  std_::unordered_set<int> set;
+  for (int i = 0; i < 10000; ++i) set.insert(i);
+  const bucket_stats stats = compute_bucket_stats(set);
+
+  EXPECT_EQ(set.size(), stats.size);
+  EXPECT_EQ(set.bucket_count(), stats.bucket_count);
+  EXPECT_EQ(set.bucket_count(), stats.buckets_examined);
+  EXPECT_EQ(set.size(), stats.elements_examined);
+  EXPECT_NEAR(set.load_factor(), stats.load_factor(), 1e-6);
+  size_t buckets = 0;
+  for (size_t count : stats.occupancy) buckets += count;
+  EXPECT_EQ(stats.bucket_count, buckets);
+
+  EXPECT_LT(stats.max_chain, 10u);
+  EXPECT_NEAR(1.0, stats.uniformity(), 0.2);
+  EXPECT_LT(stats.mean_successful_probe(), 2.0);
+  EXPECT_NEAR(stats.expected_empty_fraction(), stats.empty_fraction(), 0.02);
+}
+
+TEST(BucketStatsTest, DetectsClustering) {
+  std::unordered_set<int, ClusteringHash> set;
+  for (int i = 0; i < 10000; ++i) set.insert(i);
+  const bucket_stats stats = compute_bucket_stats(set);
+
+  EXPECT_EQ(set.size() / ClusteringHash::kNumHashes, stats.max_chain);
+  EXPECT_GT(stats.uniformity(), 100);
+  EXPECT_EQ(stats.bucket_count - ClusteringHash::kNumHashes,
+            stats.occupancy[0]);
+  EXPECT_EQ(ClusteringHash::kNumHashes,
+            stats.occupancy[bucket_stats::kMaxOccupancy]);
+}
+
+TEST(BucketStatsTest, SamplingEstimatesFullStatistics) {
+  std_::unordered_set<int> set;
+  for (int i = 0; i < 100000; ++i) set.insert(i);
+  const bucket_stats full = compute_bucket_stats(set);
+  const bucket_stats sampled = sample_bucket_stats(set, 1000, 42);
+
+  EXPECT_EQ(1000u, sampled.buckets_examined);
+  EXPECT_EQ(full.size, sampled.size);
+  EXPECT_DOUBLE_EQ(full.load_factor(), sampled.load_factor());
+  EXPECT_NEAR(full.mean_chain(), sampled.mean_chain(), 0.1);
+  EXPECT_NEAR(full.uniformity(), sampled.uniformity(), 0.2);
+
+  // The few non-empty buckets are unlikely to be sampled, but the excess of
+  // empty buckets shows.
+  std::unordered_set<int, ClusteringHash> clustered;
+  for (int i = 0; i < 10000; ++i) clustered.insert(i);
+  const bucket_stats sample = sample_bucket_stats(clustered, 1000, 42);
+  EXPECT_GT(sample.empty_fraction(), sample.expected_empty_fraction() + 0.5);
+}
+
+TEST(BucketStatsTest, ToString) {
+  std_::unordered_set<int> set = {1, 2, 3};
+  const std::string s = compute_bucket_stats(set).to_string();
+  EXPECT_NE(std::string::npos, s.find("size=3"));
+  EXPECT_NE(std::string::npos, s.find("occupancy:"));
+}
+
+}  // namespace
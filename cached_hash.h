@@ -0,0 +1,85 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Wrapper that memoizes the std_::hash of an expensive-to-hash key, so that
+// rehashing a table, or repeatedly looking up the same key object, does not
+// re-run the hash algorithm over the key's contents.
+
+#ifndef HASHING_DEMO_CACHED_HASH_H
+#define HASHING_DEMO_CACHED_HASH_H
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "std.h"
+
+namespace hashing {
+
+// Holds a value of type T together with std_::hash<T>{}(value), computed
+// once at construction. The value is only exposed as const, so the stored
+// hash can never go stale.
+template <typename T>
+class cached_hash {
+  T value_;
+  size_t hash_;
+
+ public:
+  explicit cached_hash(T value)
+      : value_(std::move(value)), hash_(std_::hash<T>{}(value_)) {}
+
+  const T& value() const { return value_; }
+  size_t hash() const { return hash_; }
+
+  // Compares the stored hashes before the values, so that most unequal
+  // keys are rejected without touching their (possibly out-of-line)
+  // contents.
+  friend bool operator==(const cached_hash& lhs, const cached_hash& rhs) {
+    return lhs.hash_ == rhs.hash_ && lhs.value_ == rhs.value_;
+  }
+
+  friend bool operator!=(const cached_hash& lhs, const cached_hash& rhs) {
+    return !(lhs == rhs);
+  }
+
+  // The hash representation of a cached_hash is its stored hash, so
+  // composite keys that contain one only mix in a single size_t for it.
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode hash_code, const cached_hash& c) {
+    return hash_combine(std::move(hash_code), c.hash_);
+  }
+};
+
+template <typename T>
+cached_hash<std::decay_t<T>> make_cached_hash(T&& value) {
+  return cached_hash<std::decay_t<T>>(std::forward<T>(value));
+}
+
+}  // namespace hashing
+
+namespace std_ {
+
+// std_::hash recognizes cached_hash, and returns the stored value rather
+// than hashing it again. This means that
+// std_::hash<cached_hash<T>>{}(c) == std_::hash<T>{}(c.value()).
+template <typename T>
+struct hash<hashing::cached_hash<T>> {
+  size_t operator()(const hashing::cached_hash<T>& c) const {
+    return c.hash();
+  }
+};
+
+}  // namespace std_
+
+#endif  // HASHING_DEMO_CACHED_HASH_H
@@ -0,0 +1,200 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Consistent hashing utilities for routing keys of any type that std_::hash
+// supports to one of N shards, such that changing N moves as few keys as
+// possible. Not part of this proposal.
+
+#ifndef HASHING_DEMO_CONSISTENT_HASH_H
+#define HASHING_DEMO_CONSISTENT_HASH_H
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "std.h"
+
+namespace hashing {
+
+// Jump consistent hash (Lamping and Veach, "A Fast, Minimal Memory,
+// Consistent Hash Algorithm"). Maps 'key' to a bucket in
+// [0, num_buckets). When num_buckets grows by one, only 1/num_buckets of
+// the keys move, all of them to the new bucket. Buckets can only be added
+// or removed at the end of the range.
+inline int32_t jump_consistent_hash(uint64_t key, int32_t num_buckets) {
+  assert(num_buckets > 0);
+  int64_t b = -1, j = 0;
+  while (j < num_buckets) {
+    b = j;
+    key = key * 2862933555777941757ULL + 1;
+    j = static_cast<int64_t>((b + 1) * (double(int64_t{1} << 31) /
+                                        double((key >> 33) + 1)));
+  }
+  return static_cast<int32_t>(b);
+}
+
+// Hashes 'key' and maps it to a bucket in [0, num_buckets) with
+// jump_consistent_hash(). Note that jump_consistent_hash() itself expects
+// its input to be a hash already; it doesn't scramble sequential integers.
+template <typename T, typename Hash = std_::hash<T>>
+int32_t jump_route(const T& key, int32_t num_buckets,
+                   const Hash& hash = Hash()) {
+  return jump_consistent_hash(static_cast<uint64_t>(hash(key)), num_buckets);
+}
+
+// Weighted rendezvous (highest random weight) hashing over an arbitrary set
+// of nodes. Each key goes to the node with the highest score, where the
+// score of a node is derived from the hashes of the key and the node
+// (Schindelhauer and Schomaker's logarithmic method, so that each node
+// receives a share of keys proportional to its weight). Adding or removing
+// a node only moves the keys that it gains or loses, and any node can be
+// removed, not just the last one.
+//
+// Node ids are hashed once, when added, so routing a key costs one hash of
+// the key plus a cheap mix per node. The per-node state is stored as
+// parallel arrays, and score_all() is a branch-free loop over them, which
+// the compiler can vectorize if it has a vector logarithm (e.g. glibc's
+// libmvec under -ffast-math). When all weights are equal, route() compares
+// the mixed hashes as integers and needs no logarithm at all.
+template <typename Node, typename Hash = std_::hash<Node>>
+class rendezvous_hash {
+ public:
+  explicit rendezvous_hash(Hash hash = Hash()) : hash_(std::move(hash)) {}
+
+  // Adds 'node' with the given weight, which must be positive.
+  void add_node(const Node& node, double weight = 1.0) {
+    assert(weight > 0);
+    nodes_.push_back(node);
+    seeds_.push_back(static_cast<uint64_t>(hash_(node)));
+    weights_.push_back(weight);
+    uniform_ = uniform_ && weight == weights_.front();
+  }
+
+  // Removes 'node', if present. Returns whether it was present.
+  bool remove_node(const Node& node) {
+    auto it = std::find(nodes_.begin(), nodes_.end(), node);
+    if (it == nodes_.end()) return false;
+    const size_t i = it - nodes_.begin();
+    nodes_.erase(nodes_.begin() + i);
+    seeds_.erase(seeds_.begin() + i);
+    weights_.erase(weights_.begin() + i);
+    uniform_ = std::all_of(weights_.begin(), weights_.end(),
+                           [this](double w) { return w == weights_.front(); });
+    return true;
+  }
+
+  const std::vector<Node>& nodes() const { return nodes_; }
+
+  // Returns the index in nodes() of the node that 'key' routes to.
+  // Requires: at least one node has been added.
+  template <typename Key, typename KeyHash = std_::hash<Key>>
+  size_t route(const Key& key, const KeyHash& key_hash = KeyHash()) const {
+    return route_hash(static_cast<uint64_t>(key_hash(key)));
+  }
+
+  // Variant of route() that takes a precomputed key hash.
+  size_t route_hash(uint64_t key_hash) const {
+    assert(!nodes_.empty());
+    if (uniform_) {
+      // With equal weights, the logarithm is monotonic in the mixed hash,
+      // so we can compare the integers directly.
+      uint64_t best_score = 0;
+      size_t best = 0;
+      for (size_t i = 0; i < seeds_.size(); ++i) {
+        const uint64_t score = mix(key_hash ^ seeds_[i]);
+        if (score > best_score) {
+          best_score = score;
+          best = i;
+        }
+      }
+      return best;
+    }
+    double best_score = 0;
+    size_t best = 0;
+    for (size_t i = 0; i < seeds_.size(); ++i) {
+      const double score = score_of(key_hash, i);
+      if (score > best_score) {
+        best_score = score;
+        best = i;
+      }
+    }
+    return best;
+  }
+
+  // Stores the score of every node for 'key' in scores[0, nodes().size()).
+  // The key routes to the node with the highest score; sorting the nodes by
+  // decreasing score gives the preference order for replica placement.
+  template <typename Key, typename KeyHash = std_::hash<Key>>
+  void score_all(const Key& key, double* scores,
+                 const KeyHash& key_hash = KeyHash()) const {
+    score_all_hash(static_cast<uint64_t>(key_hash(key)), scores);
+  }
+
+  void score_all_hash(uint64_t key_hash, double* scores) const {
+    for (size_t i = 0, n = seeds_.size(); i < n; ++i) {
+      scores[i] = score_of(key_hash, i);
+    }
+  }
+
+  // Returns the indices in nodes() of the 'n' highest-scoring nodes for
+  // 'key', best first, e.g. for choosing replicas.
+  template <typename Key, typename KeyHash = std_::hash<Key>>
+  std::vector<size_t> top_nodes(const Key& key, size_t n,
+                                const KeyHash& key_hash = KeyHash()) const {
+    std::vector<double> scores(nodes_.size());
+    score_all(key, scores.data(), key_hash);
+    std::vector<size_t> order(nodes_.size());
+    std::iota(order.begin(), order.end(), 0);
+    n = std::min(n, order.size());
+    std::partial_sort(order.begin(), order.begin() + n, order.end(),
+                      [&scores](size_t a, size_t b) {
+                        return scores[a] > scores[b];
+                      });
+    order.resize(n);
+    return order;
+  }
+
+ private:
+  double score_of(uint64_t key_hash, size_t node) const {
+    // Map the mixed hash to a uniform value in (0, 1).
+    const double u = (double(mix(key_hash ^ seeds_[node]) >> 11) + 0.5) *
+                     (1.0 / double(uint64_t{1} << 53));
+    return -weights_[node] / std::log(u);
+  }
+
+  // The MurmurHash3 64-bit finalizer, which is a bijection, so distinct
+  // (key, node) pairs rarely collide.
+  static uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  std::vector<Node> nodes_;
+  std::vector<uint64_t> seeds_;
+  std::vector<double> weights_;
+  bool uniform_ = true;
+  Hash hash_;
+};
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_CONSISTENT_HASH_H
@@ -0,0 +1,111 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "consistent_hash.h"
+
+namespace {
+
+static const int kNumKeys = 100000;
+
+TEST(JumpConsistentHashTest, OnlyMovesKeysToNewBucket) {
+  for (int32_t n = 1; n < 50; ++n) {
+    for (int key = 0; key < 1000; ++key) {
+      const int32_t before = hashing::jump_route(key, n);
+      const int32_t after = hashing::jump_route(key, n + 1);
+      ASSERT_GE(before, 0);
+      ASSERT_LT(before, n);
+      ASSERT_TRUE(after == before || after == n) << key << " " << n;
+    }
+  }
+}
+
+TEST(JumpConsistentHashTest, Balanced) {
+  std::vector<int> counts(10);
+  for (int key = 0; key < kNumKeys; ++key) {
+    ++counts[hashing::jump_route(std::to_string(key), 10)];
+  }
+  for (int count : counts) {
+    EXPECT_NEAR(kNumKeys / 10, count, kNumKeys / 100);
+  }
+}
+
+TEST(RendezvousHashTest, RemovingNodeOnlyMovesItsKeys) {
+  hashing::rendezvous_hash<std::string> router;
+  for (int i = 0; i < 10; ++i) {
+    router.add_node("node" + std::to_string(i));
+  }
+  std::vector<std::string> before(kNumKeys);
+  for (int key = 0; key < kNumKeys; ++key) {
+    before[key] = router.nodes()[router.route(key)];
+  }
+  EXPECT_TRUE(router.remove_node("node3"));
+  EXPECT_FALSE(router.remove_node("node3"));
+  for (int key = 0; key < kNumKeys; ++key) {
+    const std::string& after = router.nodes()[router.route(key)];
+    if (before[key] != "node3") {
+      ASSERT_EQ(before[key], after) << key;
+    }
+  }
+}
+
+TEST(RendezvousHashTest, WeightsAreRespected) {
+  hashing::rendezvous_hash<int> router;
+  router.add_node(0, 1.0);
+  router.add_node(1, 2.0);
+  router.add_node(2, 5.0);
+  std::vector<int> counts(3);
+  for (int key = 0; key < kNumKeys; ++key) {
+    ++counts[router.route(key)];
+  }
+  EXPECT_NEAR(kNumKeys / 8, counts[0], kNumKeys / 100);
+  EXPECT_NEAR(kNumKeys / 4, counts[1], kNumKeys / 100);
+  EXPECT_NEAR(kNumKeys * 5 / 8, counts[2], kNumKeys / 100);
+}
+
+TEST(RendezvousHashTest, UniformFastPathAgreesWithScores) {
+  hashing::rendezvous_hash<int> router;
+  for (int i = 0; i < 100; ++i) {
+    router.add_node(i);
+  }
+  std::vector<double> scores(100);
+  for (int key = 0; key < 1000; ++key) {
+    router.score_all(key, scores.data());
+    const size_t best =
+        std::max_element(scores.begin(), scores.end()) - scores.begin();
+    EXPECT_EQ(best, router.route(key)) << key;
+    EXPECT_EQ(best, router.top_nodes(key, 3)[0]) << key;
+  }
+}
+
+TEST(RendezvousHashTest, TopNodesAreDistinctAndOrdered) {
+  hashing::rendezvous_hash<int> router;
+  for (int i = 0; i < 10; ++i) {
+    router.add_node(i, 1.0 + i);
+  }
+  std::vector<double> scores(10);
+  router.score_all(std::string("key"), scores.data());
+  const std::vector<size_t> top = router.top_nodes(std::string("key"), 4);
+  ASSERT_EQ(4u, top.size());
+  for (size_t i = 1; i < top.size(); ++i) {
+    EXPECT_GT(scores[top[i - 1]], scores[top[i]]);
+  }
+}
+
+}  // namespace
@@ -0,0 +1,317 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of hash table operations, rather than of hashing alone, for
+// each combination of key type and hasher. range(0) is the number of
+// elements, from tables that fit in L1 cache to tables that only fit in
+// RAM. Each benchmark also reports the memory the table itself allocates
+// per element, excluding memory that the keys own.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "fnv1a.h"
+#include "hash_util.h"
+#include "key_corpus.h"
+#include "n3980-farmhash.h"
+#include "n3980.h"
+#include "std.h"
+
+namespace {
+
+// Bytes currently allocated through counting_allocator.
+size_t allocated_bytes = 0;
+
+template <typename T>
+struct counting_allocator {
+  using value_type = T;
+
+  counting_allocator() {}
+  template <typename U>
+  counting_allocator(const counting_allocator<U>&) {}
+
+  T* allocate(size_t n) {
+    allocated_bytes += n * sizeof(T);
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* p, size_t n) {
+    allocated_bytes -= n * sizeof(T);
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  friend bool operator==(const counting_allocator&,
+                         const counting_allocator&) {
+    return true;
+  }
+  friend bool operator!=(const counting_allocator&,
+                         const counting_allocator&) {
+    return false;
+  }
+};
+
+// A key with several fields of different types, including padding.
+struct CompositeKey {
+  std::string name;
+  int32_t id;
+  std::pair<int16_t, int64_t> extra;
+
+  friend bool operator==(const CompositeKey& lhs, const CompositeKey& rhs) {
+    return lhs.name == rhs.name && lhs.id == rhs.id && lhs.extra == rhs.extra;
+  }
+};
+
+template <typename HashCode>
+HashCode hash_value(HashCode code, const CompositeKey& key) {
+  return hash_combine(std::move(code), key.name, key.id, key.extra);
+}
+
+template <typename HashAlgorithm>
+void hash_append(HashAlgorithm& h, const CompositeKey& key) {
+  using std_::hash_append;
+  hash_append(h, key.name, key.id, key.extra);
+}
+
+// Returns the i'th key of a sequence of distinct keys. Successful lookups
+// use the first range(0) keys, and unsuccessful lookups the next range(0).
+template <typename Key>
+Key MakeKey(uint64_t i);
+
+template <>
+int MakeKey<int>(uint64_t i) {
+  // A bijection on 32 bits, so the keys are distinct but not sequential.
+  return static_cast<int>(static_cast<uint32_t>(i) * 0x9e3779b1u);
+}
+
+template <>
+std::string MakeKey<std::string>(uint64_t i) {
+  const uint64_t x = hashing::splitmix64_mix(i);
+  // A unique prefix, padded to between 8 and 39 characters.
+  std::string key = "key" + std::to_string(i) + "/";
+  key.resize(std::max<size_t>(key.size(), 8 + x % 32),
+             static_cast<char>('a' + x % 26));
+  return key;
+}
+
+template <>
+CompositeKey MakeKey<CompositeKey>(uint64_t i) {
+  const uint64_t x = hashing::splitmix64_mix(i);
+  return {MakeKey<std::string>(x % 1000), static_cast<int32_t>(i),
+          {static_cast<int16_t>(x), static_cast<int64_t>(x >> 16)}};
+}
+
+template <typename Key>
+std::vector<Key> MakeKeys(uint64_t first, size_t count) {
+  std::vector<Key> keys;
+  keys.reserve(count);
+  for (size_t i = 0; i < count; ++i) keys.push_back(MakeKey<Key>(first + i));
+  return keys;
+}
+
+// Returns a random permutation of [0, n), for looking keys up in an order
+// unrelated to the one they were generated and inserted in. Otherwise
+// node-based tables, whose nodes are allocated in insertion order, would
+// see a sequential walk of memory that the prefetcher hides.
+std::vector<size_t> ShuffledIndices(size_t n) {
+  std::vector<size_t> indices(n);
+  for (size_t i = 0; i < n; ++i) indices[i] = i;
+  std::shuffle(indices.begin(), indices.end(), std::mt19937_64(n));
+  return indices;
+}
+
+template <typename Key>
+using fnv1a_hasher = hashing::hash_code_hasher<hashing::fnv1a, Key>;
+
+template <typename Key, typename Hash>
+using Table = std::unordered_set<Key, Hash, std::equal_to<Key>,
+                                 counting_allocator<Key>>;
+
+// Reports the memory allocated by the table under test, of range(0)
+// elements, which must be the only live Table when allocated_bytes is
+// read into 'table_bytes'.
+void ReportMemory(benchmark::State& state, size_t table_bytes) {
+  state.counters["bytes/element"] = double(table_bytes) / state.range(0);
+}
+
+template <typename Key, typename Hash>
+void BM_Insert(benchmark::State& state) {
+  const std::vector<Key> keys = MakeKeys<Key>(0, state.range(0));
+  size_t table_bytes = 0;
+  while (state.KeepRunning()) {
+    Table<Key, Hash> table;
+    for (const Key& key : keys) table.insert(key);
+    benchmark::DoNotOptimize(table.size());
+    table_bytes = allocated_bytes;
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+  ReportMemory(state, table_bytes);
+}
+
+template <typename Key, typename Hash>
+void BM_FindHit(benchmark::State& state) {
+  const std::vector<Key> keys = MakeKeys<Key>(0, state.range(0));
+  const Table<Key, Hash> table(keys.begin(), keys.end());
+  const std::vector<size_t> order = ShuffledIndices(keys.size());
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(table.find(keys[order[i]]));
+    if (++i == order.size()) i = 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+  ReportMemory(state, allocated_bytes);
+}
+
+template <typename Key, typename Hash>
+void BM_FindMiss(benchmark::State& state) {
+  const std::vector<Key> keys = MakeKeys<Key>(0, state.range(0));
+  const std::vector<Key> misses = MakeKeys<Key>(keys.size(), keys.size());
+  const Table<Key, Hash> table(keys.begin(), keys.end());
+  const std::vector<size_t> order = ShuffledIndices(misses.size());
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(table.find(misses[order[i]]));
+    if (++i == order.size()) i = 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+  ReportMemory(state, allocated_bytes);
+}
+
+// Erases every key from a full table; the table is rebuilt, untimed,
+// between iterations.
+template <typename Key, typename Hash>
+void BM_Erase(benchmark::State& state) {
+  const std::vector<Key> keys = MakeKeys<Key>(0, state.range(0));
+  size_t table_bytes = 0;
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    Table<Key, Hash> table(keys.begin(), keys.end());
+    table_bytes = allocated_bytes;
+    state.ResumeTiming();
+    for (const Key& key : keys) table.erase(key);
+    benchmark::DoNotOptimize(table.size());
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+  ReportMemory(state, table_bytes);
+}
+
+template <typename Key, typename Hash>
+void BM_Iterate(benchmark::State& state) {
+  const std::vector<Key> keys = MakeKeys<Key>(0, state.range(0));
+  const Table<Key, Hash> table(keys.begin(), keys.end());
+  while (state.KeepRunning()) {
+    for (const Key& key : table) benchmark::DoNotOptimize(&key);
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+  ReportMemory(state, allocated_bytes);
+}
+
+// 64 elements fit in L1 cache, and 2M elements spill out of L3.
+#define CONTAINER_BENCHMARK(op, Key, Hash) \
+  BENCHMARK_TEMPLATE(op, Key, Hash)->RangeMultiplier(8)->Range(64, 1 << 21)
+
+// Runs 'op' with each hasher that supports 'Key', except std::hash.
+#define CONTAINER_BENCHMARKS(op, Key)                   \
+  CONTAINER_BENCHMARK(op, Key, std_::hash<Key>);        \
+  CONTAINER_BENCHMARK(op, Key, fnv1a_hasher<Key>);      \
+  CONTAINER_BENCHMARK(op, Key, std_::uhash<hashing::n3980::farmhash>)
+
+// std::hash doesn't support CompositeKey.
+#define ALL_CONTAINER_BENCHMARKS(op)                            \
+  CONTAINER_BENCHMARK(op, int, std::hash<int>);                 \
+  CONTAINER_BENCHMARKS(op, int);                                \
+  CONTAINER_BENCHMARK(op, std::string, std::hash<std::string>); \
+  CONTAINER_BENCHMARKS(op, std::string);                        \
+  CONTAINER_BENCHMARKS(op, CompositeKey)
+
+ALL_CONTAINER_BENCHMARKS(BM_Insert);
+ALL_CONTAINER_BENCHMARKS(BM_FindHit);
+ALL_CONTAINER_BENCHMARKS(BM_FindMiss);
+ALL_CONTAINER_BENCHMARKS(BM_Erase);
+ALL_CONTAINER_BENCHMARKS(BM_Iterate);
+
+// Benchmarks on a realistic corpus of distinct string keys, selected by
+// range(0) as in hashing::benchmark_key_corpus(), with range(1) keys.
+template <typename Hash>
+void BM_InsertCorpus(benchmark::State& state) {
+  const std::vector<std::string> keys =
+      hashing::benchmark_key_corpus(state.range(0), state.range(1), true);
+  if (keys.empty()) {
+    state.SkipWithError("HASHING_DEMO_KEY_CORPUS is not a readable file");
+    return;
+  }
+  while (state.KeepRunning()) {
+    Table<std::string, Hash> table;
+    for (const std::string& key : keys) table.insert(key);
+    benchmark::DoNotOptimize(table.size());
+  }
+  state.SetLabel(hashing::benchmark_key_corpus_name(state.range(0)));
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+// Looks up keys with Zipfian popularity, so that a few hot keys dominate,
+// as in most real lookup streams.
+template <typename Hash>
+void BM_FindCorpus(benchmark::State& state) {
+  const std::vector<std::string> keys =
+      hashing::benchmark_key_corpus(state.range(0), state.range(1), true);
+  if (keys.empty()) {
+    state.SkipWithError("HASHING_DEMO_KEY_CORPUS is not a readable file");
+    return;
+  }
+  const Table<std::string, Hash> table(keys.begin(), keys.end());
+  const std::vector<size_t> lookups =
+      hashing::zipfian_indices(keys.size(), 1 << 16);
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(table.find(keys[lookups[i]]));
+    if (++i == lookups.size()) i = 0;
+  }
+  state.SetLabel(hashing::benchmark_key_corpus_name(state.range(0)));
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Each generated corpus, and the HASHING_DEMO_KEY_CORPUS file if set, at
+// sizes from L1 to RAM.
+void CorpusArgs(benchmark::internal::Benchmark* b) {
+  for (int corpus = 0; corpus < int(hashing::num_benchmark_key_corpora());
+       ++corpus) {
+    for (int size = 64; size <= (1 << 21); size *= 8) {
+      b->ArgPair(corpus, size);
+    }
+  }
+}
+
+#define CORPUS_BENCHMARKS(op)                                            \
+  BENCHMARK_TEMPLATE(op, std::hash<std::string>)->Apply(CorpusArgs);     \
+  BENCHMARK_TEMPLATE(op, std_::hash<std::string>)->Apply(CorpusArgs);    \
+  BENCHMARK_TEMPLATE(op, fnv1a_hasher<std::string>)->Apply(CorpusArgs);  \
+  BENCHMARK_TEMPLATE(op, std_::uhash<hashing::n3980::farmhash>)          \
+      ->Apply(CorpusArgs)
+
+CORPUS_BENCHMARKS(BM_InsertCorpus);
+CORPUS_BENCHMARKS(BM_FindCorpus);
+
+}  // namespace
+
+BENCHMARK_MAIN();
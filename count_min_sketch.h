@@ -0,0 +1,121 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Count-min sketch (Cormode and Muthukrishnan) for any type that std_::hash
+// supports. Not part of this proposal.
+
+#ifndef HASHING_DEMO_COUNT_MIN_SKETCH_H
+#define HASHING_DEMO_COUNT_MIN_SKETCH_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "std.h"
+
+namespace hashing {
+
+// Estimates how many times each key has been added, using depth * width
+// counters. Estimates never undercount; with the standard update policy
+// they overcount by at most e/width * total_count() with probability
+// 1 - e^-depth.
+//
+// Each key is hashed once, by Hash, and the column in row i is derived by
+// double hashing (h1 + i * h2, i = 0..depth-1).
+//
+// With the conservative update policy (Estan and Varghese), add() only
+// raises the counters that are below the new estimate, which reduces the
+// overcount considerably for skewed streams. Sketches with either policy
+// can be merged, as long as they have the same dimensions.
+template <typename T, typename Hash = std_::hash<T>>
+class count_min_sketch {
+ public:
+  enum class update_policy { standard, conservative };
+
+  count_min_sketch(size_t width, size_t depth,
+                   update_policy policy = update_policy::standard,
+                   Hash hash = Hash())
+      : width_(width),
+        depth_(depth),
+        policy_(policy),
+        counters_(width * depth),
+        hash_(std::move(hash)) {
+    assert(width > 0 && depth > 0);
+  }
+
+  void add(const T& key, uint64_t count = 1) { add_hash(hash_(key), count); }
+
+  uint64_t estimate(const T& key) const { return estimate_hash(hash_(key)); }
+
+  // Variants of the above that take a precomputed hash value.
+  void add_hash(size_t hash, uint64_t count = 1) {
+    total_count_ += count;
+    if (policy_ == update_policy::standard) {
+      for (size_t row = 0; row < depth_; ++row) {
+        counters_[index(hash, row)] += count;
+      }
+      return;
+    }
+    const uint64_t target = estimate_hash(hash) + count;
+    for (size_t row = 0; row < depth_; ++row) {
+      uint64_t& counter = counters_[index(hash, row)];
+      counter = std::max(counter, target);
+    }
+  }
+
+  uint64_t estimate_hash(size_t hash) const {
+    uint64_t result = std::numeric_limits<uint64_t>::max();
+    for (size_t row = 0; row < depth_; ++row) {
+      result = std::min(result, counters_[index(hash, row)]);
+    }
+    return result;
+  }
+
+  // Adds the counts of 'other' into this sketch. Both must have the same
+  // width and depth, and use the same Hash.
+  void merge(const count_min_sketch& other) {
+    assert(width_ == other.width_ && depth_ == other.depth_);
+    for (size_t i = 0; i < counters_.size(); ++i) {
+      counters_[i] += other.counters_[i];
+    }
+    total_count_ += other.total_count_;
+  }
+
+  size_t width() const { return width_; }
+  size_t depth() const { return depth_; }
+  uint64_t total_count() const { return total_count_; }
+
+ private:
+  size_t index(size_t hash, size_t row) const {
+    const uint32_t h1 = static_cast<uint32_t>(hash);
+    const uint32_t h2 = static_cast<uint32_t>(hash >> 32) | 1;
+    const uint32_t column = h1 + static_cast<uint32_t>(row) * h2;
+    // Maps column onto [0, width_) without a division.
+    return row * width_ + ((uint64_t{column} * width_) >> 32);
+  }
+
+  size_t width_;
+  size_t depth_;
+  update_policy policy_;
+  std::vector<uint64_t> counters_;
+  uint64_t total_count_ = 0;
+  Hash hash_;
+};
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_COUNT_MIN_SKETCH_H
@@ -0,0 +1,217 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Cuckoo filter (Fan et al., "Cuckoo Filter: Practically Better Than
+// Bloom") for any type that std_::hash supports. Unlike a Bloom filter,
+// it supports erase(). Not part of this proposal.
+
+#ifndef HASHING_DEMO_CUCKOO_FILTER_H
+#define HASHING_DEMO_CUCKOO_FILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "std.h"
+
+namespace hashing {
+
+// Cuckoo filter with 4-way buckets of 16-bit fingerprints.
+//
+// The key is hashed exactly once, by Hash: the low bits select the primary
+// bucket, and the upper 16 bits are the fingerprint. The alternate bucket
+// is derived from the primary bucket and the fingerprint alone ("partial-key
+// cuckoo hashing"), so entries can be relocated without the original key.
+template <typename T, typename Hash = std_::hash<T>>
+class cuckoo_filter {
+ public:
+  static constexpr size_t kSlotsPerBucket = 4;
+  static constexpr int kMaxKicks = 500;
+
+  // Constructs a filter with room for at least 'capacity' keys at a 95%
+  // load factor.
+  explicit cuckoo_filter(size_t capacity, Hash hash = Hash())
+      : num_buckets_(bucket_count_for(capacity)),
+        buckets_(num_buckets_),
+        hash_(std::move(hash)) {}
+
+  // Inserts 'key'. Returns false if the filter is too full to accept it;
+  // in that case the filter is unchanged, except that it may now reject
+  // all further insertions.
+  bool insert(const T& key) { return insert_hash(hash_(key)); }
+
+  // Returns false if 'key' has definitely not been inserted, and true if it
+  // probably has.
+  bool possibly_contains(const T& key) const {
+    return possibly_contains_hash(hash_(key));
+  }
+
+  // Removes one copy of 'key'. 'key' must previously have been inserted,
+  // or else some other key that shares its fingerprint may be removed.
+  bool erase(const T& key) { return erase_hash(hash_(key)); }
+
+  // Variants of the above that take a precomputed hash value.
+  bool insert_hash(size_t hash) {
+    if (has_victim_) return false;
+    uint16_t fp = fingerprint(hash);
+    size_t i1 = primary_index(hash);
+    size_t i2 = alternate_index(i1, fp);
+    if (buckets_[i1].insert(fp) || buckets_[i2].insert(fp)) {
+      ++size_;
+      return true;
+    }
+    // Both buckets are full, so evict entries along a random walk until
+    // one of them finds an empty slot. The walk is seeded from the hash,
+    // so that the filter's contents are deterministic.
+    size_t i = (hash & 1) ? i2 : i1;
+    for (int kick = 0; kick < kMaxKicks; ++kick) {
+      uint16_t& slot =
+          buckets_[i].slots[(hash >> (32 + 2 * (kick % 8))) & 3];
+      std::swap(fp, slot);
+      i = alternate_index(i, fp);
+      if (buckets_[i].insert(fp)) {
+        ++size_;
+        return true;
+      }
+    }
+    // Keep the last evicted fingerprint, so that no earlier key becomes a
+    // false negative.
+    has_victim_ = true;
+    victim_index_ = i;
+    victim_fingerprint_ = fp;
+    ++size_;
+    return true;
+  }
+
+  bool possibly_contains_hash(size_t hash) const {
+    uint16_t fp = fingerprint(hash);
+    size_t i1 = primary_index(hash);
+    size_t i2 = alternate_index(i1, fp);
+    return buckets_[i1].contains(fp) | buckets_[i2].contains(fp) |
+           (has_victim_ && victim_fingerprint_ == fp &&
+            (victim_index_ == i1 || victim_index_ == i2));
+  }
+
+  bool erase_hash(size_t hash) {
+    uint16_t fp = fingerprint(hash);
+    size_t i1 = primary_index(hash);
+    size_t i2 = alternate_index(i1, fp);
+    if (has_victim_ && victim_fingerprint_ == fp &&
+        (victim_index_ == i1 || victim_index_ == i2)) {
+      has_victim_ = false;
+    } else if (!buckets_[i1].erase(fp) && !buckets_[i2].erase(fp)) {
+      return false;
+    }
+    --size_;
+    // Now that a slot is free, try to put the victim back into the table.
+    if (has_victim_) {
+      has_victim_ = false;
+      --size_;
+      insert_hash_at(victim_index_, victim_fingerprint_);
+    }
+    return true;
+  }
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return num_buckets_ * kSlotsPerBucket; }
+  size_t size_in_bits() const { return capacity() * 16; }
+
+ private:
+  struct bucket {
+    // 0 marks an empty slot; fingerprint() never returns 0.
+    uint16_t slots[kSlotsPerBucket] = {};
+
+    // Tests all slots without branching, so the compiler can compare the
+    // whole bucket at once.
+    bool contains(uint16_t fp) const {
+      bool found = false;
+      for (size_t i = 0; i < kSlotsPerBucket; ++i) {
+        found |= slots[i] == fp;
+      }
+      return found;
+    }
+
+    bool insert(uint16_t fp) {
+      for (uint16_t& slot : slots) {
+        if (slot == 0) {
+          slot = fp;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    bool erase(uint16_t fp) {
+      for (uint16_t& slot : slots) {
+        if (slot == fp) {
+          slot = 0;
+          return true;
+        }
+      }
+      return false;
+    }
+  };
+
+  static size_t bucket_count_for(size_t capacity) {
+    // The number of buckets must be a power of two, so that
+    // alternate_index() is an involution.
+    size_t needed =
+        static_cast<size_t>(capacity / 0.95 / kSlotsPerBucket) + 1;
+    size_t count = 1;
+    while (count < needed) count *= 2;
+    return count;
+  }
+
+  static uint16_t fingerprint(size_t hash) {
+    uint16_t fp = static_cast<uint16_t>(hash >> 48);
+    return fp == 0 ? 1 : fp;
+  }
+
+  size_t primary_index(size_t hash) const {
+    return hash & (num_buckets_ - 1);
+  }
+
+  size_t alternate_index(size_t index, uint16_t fp) const {
+    // Multiply by the MurmurHash2 constant, so that similar fingerprints
+    // map to distant buckets.
+    return (index ^ (fp * size_t{0x5bd1e995})) & (num_buckets_ - 1);
+  }
+
+  void insert_hash_at(size_t index, uint16_t fp) {
+    if (buckets_[index].insert(fp) ||
+        buckets_[alternate_index(index, fp)].insert(fp)) {
+      ++size_;
+      return;
+    }
+    has_victim_ = true;
+    victim_index_ = index;
+    victim_fingerprint_ = fp;
+    ++size_;
+  }
+
+  size_t num_buckets_;
+  std::vector<bucket> buckets_;
+  size_t size_ = 0;
+
+  bool has_victim_ = false;
+  size_t victim_index_ = 0;
+  uint16_t victim_fingerprint_ = 0;
+
+  Hash hash_;
+};
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_CUCKOO_FILTER_H
@@ -12,7 +12,24 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#endif
 
 #include "std.h"
 
@@ -71,7 +88,321 @@ class identity {
   }
 };
 
+// Append-only byte storage made of fixed-size blocks, so that recording a
+// long byte stream never copies what has already been recorded, as growing
+// a std::string would. clear() keeps the blocks for reuse.
+class byte_arena {
+ public:
+  static constexpr size_t kBlockSize = 1 << 20;
+
+  void append(const unsigned char* begin, const unsigned char* end) {
+    while (begin != end) {
+      if (size_ == blocks_.size() * kBlockSize) {
+        blocks_.emplace_back(new unsigned char[kBlockSize]);
+      }
+      const size_t offset = size_ % kBlockSize;
+      const size_t n =
+          std::min<size_t>(end - begin, kBlockSize - offset);
+      memcpy(blocks_[size_ / kBlockSize].get() + offset, begin, n);
+      begin += n;
+      size_ += n;
+    }
+  }
+
+  size_t size() const { return size_; }
+
+  void clear() { size_ = 0; }
+
+  // Calls f(const unsigned char* begin, const unsigned char* end) on each
+  // block of the contents, in order.
+  template <typename F>
+  void for_each_block(F f) const {
+    for (size_t offset = 0; offset < size_; offset += kBlockSize) {
+      const unsigned char* block = blocks_[offset / kBlockSize].get();
+      f(block, block + std::min(kBlockSize, size_ - offset));
+    }
+  }
+
+  std::string str() const {
+    std::string result;
+    result.reserve(size_);
+    for_each_block([&result](const unsigned char* begin,
+                             const unsigned char* end) {
+      result.append(begin, end);
+    });
+    return result;
+  }
+
+ private:
+  std::vector<std::unique_ptr<unsigned char[]>> blocks_;
+  size_t size_ = 0;
+};
+
+class profiling_hash_code;
+
+// Records how values are hashed, broken down by type, in order to find
+// types whose hashing is fragmented into many small byte ranges, or that
+// miss the bulk path for ranges. Each hash_profile collects the statistics
+// of any number of keys:
+//
+//   hashing::hash_profile profile;
+//   for (const auto& key : keys) profile.hash(key);
+//   std::cout << profile.report();
+//
+// Bytes and byte ranges are attributed to the innermost type being hashed
+// when they're passed to hash_combine_range(), so a type's own fields are
+// counted under the field types, and only the bytes a hash_value() adds
+// directly (e.g. a container's size) are counted under the type itself.
+// Range statistics are attributed to the type whose hash_value() called
+// hash_combine_range().
+//
+// If 'record_bytes' is true, the hashed byte stream, i.e. what
+// hashing::identity would produce for each key, is also kept in an arena.
+class hash_profile {
+ public:
+  struct type_stats {
+    std::string type_name;
+    // Number of values hashed via hash_value(), or as their bytes if
+    // uniquely represented.
+    uint64_t values = 0;
+    // Bytes passed to hash_combine_range(), and the number of calls.
+    uint64_t bytes = 0;
+    uint64_t byte_ranges = 0;
+    // Number of hash_combine_range() calls over a range that was hashed in
+    // bulk (as bytes), or one element at a time, and the total number of
+    // elements in the latter.
+    uint64_t bulk_ranges = 0;
+    uint64_t elementwise_ranges = 0;
+    uint64_t elements = 0;
+  };
+
+  explicit hash_profile(bool record_bytes = false)
+      : record_bytes_(record_bytes) {
+    stats_.push_back(type_stats{"<top level>"});
+  }
+
+  hash_profile(const hash_profile&) = delete;
+  hash_profile& operator=(const hash_profile&) = delete;
+
+  // Hashes 'value' with profiling_hash_code, recording its statistics.
+  // Returns the number of bytes hashed.
+  template <typename T>
+  size_t hash(const T& value);
+
+  uint64_t num_keys() const { return num_keys_; }
+  uint64_t total_bytes() const { return total_bytes_; }
+
+  // Returns the statistics of every type seen so far, with the most bytes
+  // first.
+  std::vector<type_stats> stats() const {
+    std::vector<type_stats> result;
+    for (const type_stats& s : stats_) {
+      if (s.values != 0 || s.byte_ranges != 0) result.push_back(s);
+    }
+    std::stable_sort(result.begin(), result.end(),
+                     [](const type_stats& a, const type_stats& b) {
+                       return a.bytes > b.bytes;
+                     });
+    return result;
+  }
+
+  // Returns the statistics as a table with one row per type.
+  std::string report() const {
+    std::ostringstream out;
+    out << num_keys_ << " keys, " << total_bytes_ << " bytes\n";
+    out << std::setw(12) << "values" << std::setw(14) << "bytes"
+        << std::setw(12) << "ranges" << std::setw(12) << "bytes/range"
+        << std::setw(10) << "bulk" << std::setw(12) << "elementwise"
+        << std::setw(12) << "elements" << "  type\n";
+    for (const type_stats& s : stats()) {
+      out << std::setw(12) << s.values << std::setw(14) << s.bytes
+          << std::setw(12) << s.byte_ranges << std::setw(12)
+          << std::fixed << std::setprecision(1)
+          << (s.byte_ranges == 0 ? 0.0 : double(s.bytes) / s.byte_ranges)
+          << std::setw(10) << s.bulk_ranges << std::setw(12)
+          << s.elementwise_ranges << std::setw(12) << s.elements << "  "
+          << s.type_name << "\n";
+    }
+    return out.str();
+  }
 
+  // The hashed bytes of all keys, in order, if record_bytes was set.
+  const byte_arena& recorded_bytes() const { return arena_; }
 
+  void clear() {
+    stats_.resize(1);
+    stats_[0] = type_stats{"<top level>"};
+    type_indices_.clear();
+    num_keys_ = 0;
+    total_bytes_ = 0;
+    arena_.clear();
+  }
+
+ private:
+  friend class profiling_hash_code;
+
+  template <typename T>
+  void push_type() {
+    auto inserted = type_indices_.emplace(typeid(T), stats_.size());
+    if (inserted.second) stats_.push_back(type_stats{type_name<T>()});
+    type_stack_.push_back(inserted.first->second);
+    ++current().values;
+  }
+
+  void pop_type() { type_stack_.pop_back(); }
+
+  // Index into stats_ of the innermost type being hashed.
+  size_t current_index() const {
+    return type_stack_.empty() ? 0 : type_stack_.back();
+  }
+
+  type_stats& current() { return stats_[current_index()]; }
+
+  void record_bytes(const unsigned char* begin, const unsigned char* end) {
+    type_stats& s = current();
+    s.bytes += end - begin;
+    ++s.byte_ranges;
+    total_bytes_ += end - begin;
+    if (record_bytes_) arena_.append(begin, end);
+  }
+
+  template <typename T>
+  static std::string type_name() {
+    const char* name = typeid(T).name();
+#if defined(__GNUC__)
+    int status = 0;
+    std::unique_ptr<char, void (*)(void*)> demangled(
+        abi::__cxa_demangle(name, nullptr, nullptr, &status), std::free);
+    if (status == 0) return demangled.get();
+#endif
+    return name;
+  }
+
+  bool record_bytes_;
+  std::vector<type_stats> stats_;
+  std::unordered_map<std::type_index, size_t> type_indices_;
+  std::vector<size_t> type_stack_;
+  uint64_t num_keys_ = 0;
+  uint64_t total_bytes_ = 0;
+  byte_arena arena_;
+};
+
+// HashCode that records into a hash_profile. It follows the same paths as
+// the HashCodes built on std_::simple_hash_combine(): uniquely-represented
+// values and contiguous ranges of them are hashed as bytes, and everything
+// else via hash_value(). Its result is the number of bytes hashed.
+class profiling_hash_code {
+ public:
+  using result_type = size_t;
+
+  explicit profiling_hash_code(hash_profile* profile) : profile_(profile) {}
+
+  profiling_hash_code(const profiling_hash_code&) = delete;
+  profiling_hash_code& operator=(const profiling_hash_code&) = delete;
+  profiling_hash_code(profiling_hash_code&&) = default;
+  profiling_hash_code& operator=(profiling_hash_code&&) = default;
+
+  template <typename T, typename... Ts>
+  friend profiling_hash_code hash_combine(
+      profiling_hash_code code, const T& value, const Ts&... values) {
+    return hash_combine(combine_one(std::move(code), value), values...);
+  }
+
+  friend profiling_hash_code hash_combine(profiling_hash_code code) {
+    return code;
+  }
+
+  template <typename InputIterator>
+  friend profiling_hash_code hash_combine_range(
+      profiling_hash_code code, InputIterator begin, InputIterator end) {
+    const size_t index = code.profile_index();
+    if constexpr (std_::detail::can_hash_range_as_bytes<
+                      InputIterator>::value) {
+      ++code.stats(index).bulk_ranges;
+      const auto pointers =
+          std_::detail::contiguous_range_pointers(begin, end);
+      return hash_combine_range(
+          std::move(code),
+          reinterpret_cast<const unsigned char*>(pointers.first),
+          reinterpret_cast<const unsigned char*>(pointers.second));
+    } else {
+      ++code.stats(index).elementwise_ranges;
+      for (; begin != end; ++begin) {
+        ++code.stats(index).elements;
+        code = combine_one(std::move(code), *begin);
+      }
+      return code;
+    }
+  }
+
+  friend profiling_hash_code hash_combine_range(
+      profiling_hash_code code, const unsigned char* begin,
+      const unsigned char* end) {
+    code.record_bytes(begin, end);
+    return code;
+  }
+
+  explicit operator result_type() && { return bytes_; }
+
+ private:
+  // The stats_ entry at 'index'. Callers keep the index rather than a
+  // reference, since stats_ grows as types are seen.
+  hash_profile::type_stats& stats(size_t index) {
+    return profile_->stats_[index];
+  }
+
+  size_t profile_index() const { return profile_->current_index(); }
+
+  void record_bytes(const unsigned char* begin, const unsigned char* end) {
+    profile_->record_bytes(begin, end);
+    bytes_ += end - begin;
+  }
+
+  template <typename T>
+  static profiling_hash_code combine_one(profiling_hash_code code,
+                                         const T& value) {
+    hash_profile* profile = code.profile_;
+    profile->push_type<T>();
+    if constexpr (std_::is_uniquely_represented<T>::value) {
+      const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+      code = hash_combine_range(std::move(code), bytes, bytes + sizeof(T));
+    } else {
+      using std_::hash_value;
+      code = hash_value(std::move(code), value);
+    }
+    profile->pop_type();
+    return code;
+  }
+
+  friend struct std_::detail::unordered_element_hasher<profiling_hash_code>;
+
+  hash_profile* profile_;
+  size_t bytes_ = 0;
+};
+
+template <typename T>
+size_t hash_profile::hash(const T& value) {
+  ++num_keys_;
+  return profiling_hash_code::result_type(
+      hash_combine(profiling_hash_code(this), value));
+}
 
 }  // namespace hashing
+
+namespace std_ {
+namespace detail {
+
+// The elements of unordered containers are profiled too, each with a fresh
+// profiling_hash_code on the same hash_profile.
+template <>
+struct unordered_element_hasher<hashing::profiling_hash_code> {
+  template <typename T>
+  static size_t hash(const hashing::profiling_hash_code& code,
+                     const T& value) {
+    return hashing::profiling_hash_code::result_type(
+        hash_combine(hashing::profiling_hash_code(code.profile_), value));
+  }
+};
+
+}  // namespace detail
+}  // namespace std_
@@ -0,0 +1,133 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "debug.h"
+
+namespace {
+
+using ::hashing::byte_arena;
+using ::hashing::hash_profile;
+
+template <typename T>
+std::string Identity(const T& value) {
+  using std_::hash_value;
+  return hashing::identity::result_type(
+      hash_value(hashing::identity(), value));
+}
+
+// Returns the stats of the first type whose name starts with 'prefix'.
+// Demangled names vary, e.g. in how they spell default template arguments.
+const hash_profile::type_stats* FindStats(
+    const std::vector<hash_profile::type_stats>& stats,
+    const std::string& prefix) {
+  for (const auto& s : stats) {
+    if (s.type_name.compare(0, prefix.size(), prefix) == 0) return &s;
+  }
+  return nullptr;
+}
+
+TEST(ByteArenaTest, AppendsAcrossBlocks) {
+  byte_arena arena;
+  std::string expected;
+  for (int i = 0; i < 3000; ++i) {
+    const std::string chunk(1000, static_cast<char>('a' + i % 26));
+    arena.append(reinterpret_cast<const unsigned char*>(chunk.data()),
+                 reinterpret_cast<const unsigned char*>(chunk.data()) +
+                     chunk.size());
+    expected += chunk;
+  }
+  EXPECT_EQ(expected.size(), arena.size());
+  EXPECT_EQ(expected, arena.str());
+
+  arena.clear();
+  EXPECT_EQ(0u, arena.size());
+  EXPECT_EQ("", arena.str());
+}
+
+TEST(HashProfileTest, RecordsSameBytesAsIdentity) {
+  hash_profile profile(/*record_bytes=*/true);
+  const std::vector<std::string> strings = {"a", "bc", ""};
+  const auto tuple = std::make_tuple(1, std::string("x"), 2.5);
+  size_t bytes = profile.hash(strings);
+  bytes += profile.hash(tuple);
+  bytes += profile.hash(42);
+
+  const std::string expected =
+      Identity(strings) + Identity(tuple) + Identity(42);
+  EXPECT_EQ(expected, profile.recorded_bytes().str());
+  EXPECT_EQ(expected.size(), bytes);
+  EXPECT_EQ(expected.size(), profile.total_bytes());
+  EXPECT_EQ(3u, profile.num_keys());
+}
+
+TEST(HashProfileTest, DistinguishesBulkAndElementwiseRanges) {
+  hash_profile profile;
+  profile.hash(std::vector<int>{1, 2, 3});
+  profile.hash(std::vector<std::string>{"a", "bc"});
+  const auto stats = profile.stats();
+
+  const auto* ints = FindStats(stats, "std::vector<int");
+  ASSERT_NE(nullptr, ints);
+  EXPECT_EQ(1u, ints->values);
+  EXPECT_EQ(1u, ints->bulk_ranges);
+  EXPECT_EQ(0u, ints->elementwise_ranges);
+  // The elements' bytes, in one range. The size is counted under size_t.
+  EXPECT_EQ(3 * sizeof(int), ints->bytes);
+  EXPECT_EQ(1u, ints->byte_ranges);
+
+  const auto* sizes = FindStats(stats, "unsigned long");
+  ASSERT_NE(nullptr, sizes);
+  // One for each container, including the strings.
+  EXPECT_EQ(4u, sizes->values);
+  EXPECT_EQ(4 * sizeof(size_t), sizes->bytes);
+
+  const auto* strings = FindStats(stats, "std::vector<std::");
+  ASSERT_NE(nullptr, strings);
+  EXPECT_EQ(0u, strings->bulk_ranges);
+  EXPECT_EQ(1u, strings->elementwise_ranges);
+  EXPECT_EQ(2u, strings->elements);
+}
+
+TEST(HashProfileTest, ProfilesUnorderedContainerElements) {
+  hash_profile profile;
+  profile.hash(std::unordered_set<int>{1, 2, 3});
+  const auto stats = profile.stats();
+
+  const auto* ints = FindStats(stats, "int");
+  ASSERT_NE(nullptr, ints);
+  EXPECT_EQ(3u, ints->values);
+  EXPECT_EQ(3 * sizeof(int), ints->bytes);
+}
+
+TEST(HashProfileTest, ReportListsTypes) {
+  hash_profile profile;
+  profile.hash(std::make_pair(1, 2.5));
+  const std::string report = profile.report();
+  EXPECT_NE(std::string::npos, report.find("1 keys"));
+  EXPECT_NE(std::string::npos, report.find("std::pair<int, double>"));
+  EXPECT_NE(std::string::npos, report.find("double"));
+
+  profile.clear();
+  EXPECT_EQ(0u, profile.num_keys());
+  EXPECT_TRUE(profile.stats().empty());
+}
+
+}  // namespace
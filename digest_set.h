@@ -0,0 +1,214 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Unordered containers that maintain their own hash incrementally, so that
+// it can be queried in O(1), e.g. to compare replicas of a large set. Not
+// part of this proposal.
+
+#ifndef HASHING_DEMO_DIGEST_SET_H
+#define HASHING_DEMO_DIGEST_SET_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#include "std.h"
+
+namespace hashing {
+
+// An unordered set that keeps digest() equal to the sum of std_::hash of
+// its elements, which is the order-independent hash representation that
+// std_impl.h uses for unordered containers. Each insert() adds the new
+// element's hash, and each erase() subtracts it, so
+//
+//   std_::hash<digest_set<Key>>{}(s) ==
+//       std_::hash<std::unordered_set<Key>>{}(<the same elements>)
+//
+// but costs O(1) instead of O(size()). Only const access to the elements is
+// provided, since modifying an element in place would invalidate the
+// digest.
+template <typename Key, typename KeyEqual = std::equal_to<Key>,
+          typename Allocator = std::allocator<Key>>
+class digest_set {
+  using set_type = std_::unordered_set<Key, std_::hash<Key>, KeyEqual,
+                                       Allocator>;
+
+ public:
+  using value_type = Key;
+  using size_type = typename set_type::size_type;
+  using iterator = typename set_type::const_iterator;
+  using const_iterator = typename set_type::const_iterator;
+
+  digest_set() {}
+
+  template <typename InputIterator>
+  digest_set(InputIterator begin, InputIterator end) {
+    insert(begin, end);
+  }
+
+  std::pair<iterator, bool> insert(const Key& key) {
+    const size_t hash = std_::hash<Key>{}(key);
+    auto result = set_.insert(key);
+    if (result.second) digest_ += hash;
+    return result;
+  }
+
+  template <typename InputIterator>
+  void insert(InputIterator begin, InputIterator end) {
+    for (; begin != end; ++begin) {
+      insert(*begin);
+    }
+  }
+
+  size_type erase(const Key& key) {
+    auto it = set_.find(key);
+    if (it == set_.end()) return 0;
+    erase(it);
+    return 1;
+  }
+
+  iterator erase(const_iterator pos) {
+    digest_ -= std_::hash<Key>{}(*pos);
+    return set_.erase(pos);
+  }
+
+  void clear() {
+    set_.clear();
+    digest_ = 0;
+  }
+
+  const_iterator find(const Key& key) const { return set_.find(key); }
+  size_type count(const Key& key) const { return set_.count(key); }
+
+  const_iterator begin() const { return set_.begin(); }
+  const_iterator end() const { return set_.end(); }
+  size_type size() const { return set_.size(); }
+  bool empty() const { return set_.empty(); }
+
+  // Returns the sum (mod 2^64) of std_::hash of all elements. Two sets with
+  // equal elements have equal digests, regardless of the order of the
+  // operations that built them.
+  size_t digest() const { return digest_; }
+
+  friend bool operator==(const digest_set& lhs, const digest_set& rhs) {
+    // The digest comparison rejects almost all unequal sets in O(1).
+    return lhs.digest_ == rhs.digest_ && lhs.set_ == rhs.set_;
+  }
+
+  friend bool operator!=(const digest_set& lhs, const digest_set& rhs) {
+    return !(lhs == rhs);
+  }
+
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode hash_code, const digest_set& s) {
+    // Matches std_::detail::hash_unordered_container for std_::hash_code,
+    // whose element hashes are std_::hash. Other HashCodes hash the
+    // elements of an equal std_::unordered_set differently.
+    return hash_combine(std::move(hash_code), s.digest_,
+                        static_cast<size_t>(s.size()));
+  }
+
+ private:
+  set_type set_;
+  size_t digest_ = 0;
+};
+
+// The map counterpart of digest_set: digest() is the sum of std_::hash of
+// the (key, value) pairs. Values can only be changed through
+// insert_or_assign(), which updates the digest.
+template <typename Key, typename T, typename KeyEqual = std::equal_to<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
+class digest_map {
+  using map_type =
+      std::unordered_map<Key, T, std_::hash<Key>, KeyEqual, Allocator>;
+
+ public:
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = typename map_type::value_type;
+  using size_type = typename map_type::size_type;
+  using iterator = typename map_type::const_iterator;
+  using const_iterator = typename map_type::const_iterator;
+
+  digest_map() {}
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    auto result = map_.insert(value);
+    if (result.second) digest_ += std_::hash<value_type>{}(*result.first);
+    return result;
+  }
+
+  std::pair<iterator, bool> insert_or_assign(const Key& key, T value) {
+    auto it = map_.find(key);
+    if (it == map_.end()) {
+      return insert(value_type(key, std::move(value)));
+    }
+    digest_ -= std_::hash<value_type>{}(*it);
+    it->second = std::move(value);
+    digest_ += std_::hash<value_type>{}(*it);
+    return {it, false};
+  }
+
+  size_type erase(const Key& key) {
+    auto it = map_.find(key);
+    if (it == map_.end()) return 0;
+    erase(it);
+    return 1;
+  }
+
+  iterator erase(const_iterator pos) {
+    digest_ -= std_::hash<value_type>{}(*pos);
+    return map_.erase(pos);
+  }
+
+  void clear() {
+    map_.clear();
+    digest_ = 0;
+  }
+
+  const_iterator find(const Key& key) const { return map_.find(key); }
+  size_type count(const Key& key) const { return map_.count(key); }
+  const T& at(const Key& key) const { return map_.at(key); }
+
+  const_iterator begin() const { return map_.begin(); }
+  const_iterator end() const { return map_.end(); }
+  size_type size() const { return map_.size(); }
+  bool empty() const { return map_.empty(); }
+
+  size_t digest() const { return digest_; }
+
+  friend bool operator==(const digest_map& lhs, const digest_map& rhs) {
+    return lhs.digest_ == rhs.digest_ && lhs.map_ == rhs.map_;
+  }
+
+  friend bool operator!=(const digest_map& lhs, const digest_map& rhs) {
+    return !(lhs == rhs);
+  }
+
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode hash_code, const digest_map& m) {
+    return hash_combine(std::move(hash_code), m.digest_,
+                        static_cast<size_t>(m.size()));
+  }
+
+ private:
+  map_type map_;
+  size_t digest_ = 0;
+};
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_DIGEST_SET_H
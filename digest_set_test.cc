@@ -0,0 +1,95 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "gtest/gtest.h"
+
+#include "digest_set.h"
+
+namespace {
+
+TEST(DigestSetTest, DigestIsIndependentOfHistory) {
+  hashing::digest_set<std::string> a, b;
+  for (int i = 0; i < 100; ++i) {
+    a.insert(std::to_string(i));
+  }
+  for (int i = 199; i >= 0; --i) {
+    b.insert(std::to_string(i));
+  }
+  EXPECT_NE(a.digest(), b.digest());
+  for (int i = 100; i < 200; ++i) {
+    EXPECT_EQ(1u, b.erase(std::to_string(i)));
+  }
+  EXPECT_EQ(0u, b.erase("nonexistent"));
+  EXPECT_EQ(a.digest(), b.digest());
+  EXPECT_TRUE(a == b);
+
+  b.insert("0");
+  EXPECT_EQ(a.digest(), b.digest()) << "duplicate insert changed digest";
+}
+
+TEST(DigestSetTest, HashMatchesUnorderedSet) {
+  hashing::digest_set<int> digest;
+  std::unordered_set<int> plain;
+  for (int i = 0; i < 1000; i += 3) {
+    digest.insert(i);
+    plain.insert(i);
+  }
+  digest.erase(digest.find(300));
+  plain.erase(300);
+  EXPECT_EQ(std_::hash<std::unordered_set<int>>{}(plain),
+            std_::hash<hashing::digest_set<int>>{}(digest));
+}
+
+TEST(DigestSetTest, ClearResetsDigest) {
+  hashing::digest_set<int> s;
+  s.insert(1);
+  s.clear();
+  EXPECT_TRUE(s.empty());
+  EXPECT_EQ(0u, s.digest());
+}
+
+TEST(DigestMapTest, InsertOrAssignUpdatesDigest) {
+  hashing::digest_map<std::string, int> a, b;
+  a.insert({"x", 1});
+  a.insert({"y", 2});
+  b.insert({"y", 5});
+  b.insert({"x", 1});
+  EXPECT_NE(a.digest(), b.digest());
+  EXPECT_FALSE(b.insert_or_assign("y", 2).second);
+  EXPECT_EQ(a.digest(), b.digest());
+  EXPECT_TRUE(a == b);
+  EXPECT_EQ(2, b.at("y"));
+
+  EXPECT_TRUE(b.insert_or_assign("z", 3).second);
+  EXPECT_EQ(1u, b.erase("z"));
+  EXPECT_EQ(a.digest(), b.digest());
+}
+
+TEST(DigestMapTest, HashMatchesUnorderedMap) {
+  hashing::digest_map<std::string, int> digest;
+  std::unordered_map<std::string, int> plain;
+  for (int i = 0; i < 100; ++i) {
+    digest.insert_or_assign(std::to_string(i), i);
+    plain[std::to_string(i)] = i;
+  }
+  EXPECT_EQ(
+      (std_::hash<std::unordered_map<std::string, int>>{}(plain)),
+      (std_::hash<hashing::digest_map<std::string, int>>{}(digest)));
+}
+
+}  // namespace
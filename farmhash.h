@@ -24,6 +24,7 @@
 #include <cstring>
 #include <utility>
 
+#include "farmhash_counters.h"
 #include "std_impl.h"
 
 using std::uint64_t;
@@ -154,6 +155,9 @@ farmhash hash_combine_range(
 // into the hash state.
 inline farmhash hash_combine_range(
     farmhash hash_code, const unsigned char* begin, const unsigned char* end) {
+  detail::farmhash_count_range(end - begin);
+  // Empty ranges may be null, which memcpy doesn't allow.
+  if (begin == end) return hash_code;
   unsigned char* const buffer =
       reinterpret_cast <unsigned char*>(hash_code.state_->buffer_);
   const size_t buffer_remaining = buffer + 64 - hash_code.buffer_next_;
@@ -193,17 +197,21 @@ inline farmhash::operator result_type() && {
     // logic for hashing short strings
     if (len <= 32) {
       if (len <= 16) {
+        detail::farmhash_count(detail::farmhash_thread_counters::kLen0To16);
         return state_type::HashLen0to16(
             reinterpret_cast<unsigned char*>(state_->buffer_), len);
       } else {
+        detail::farmhash_count(detail::farmhash_thread_counters::kLen17To32);
         return state_type::HashLen17to32(
             reinterpret_cast<unsigned char*>(state_->buffer_), len);
       }
     } else {
+      detail::farmhash_count(detail::farmhash_thread_counters::kLen33To64);
       return state_type::HashLen33to64(
           reinterpret_cast<unsigned char*>(state_->buffer_), len);
     }
   } else {
+    detail::farmhash_count(detail::farmhash_thread_counters::kFinalMixes);
     // Note that 0 < len <= 64, due to the invariant of buffer_next_
     return state_->final_mix(len);
   }
@@ -317,6 +325,7 @@ inline void farmhash::state_type::initialize() {
 }
 
 inline void farmhash::state_type::mix() {
+  detail::farmhash_count(detail::farmhash_thread_counters::kMixes);
   x_ = Rotate(x_ + y_ + v_.first + buffer_[1], 37) * k1;
   y_ = Rotate(y_ + v_.second + buffer_[6], 42) * k1;
   x_ ^= w_.second;
@@ -0,0 +1,219 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Optional performance counters for farmhash, and therefore std_::hash,
+// showing which input length regimes dominate a workload. They're compiled
+// in only if HASHING_DEMO_FARMHASH_COUNTERS is defined to 1, which must be
+// done consistently for every translation unit in a program. Otherwise the
+// counting calls compile to nothing, and snapshots are all zeros. Not part
+// of this proposal.
+
+#ifndef HASHING_DEMO_FARMHASH_COUNTERS_H
+#define HASHING_DEMO_FARMHASH_COUNTERS_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#ifndef HASHING_DEMO_FARMHASH_COUNTERS
+#define HASHING_DEMO_FARMHASH_COUNTERS 0
+#endif
+
+namespace hashing {
+
+// A snapshot of the farmhash counters, summed over all threads, including
+// threads that have exited.
+struct farmhash_counters {
+  static constexpr bool kEnabled = HASHING_DEMO_FARMHASH_COUNTERS;
+
+  // Number of buckets in the range_sizes histogram.
+  static constexpr size_t kNumSizeBuckets = 16;
+
+  // Hashes finalized by the short-input paths, i.e. without ever calling
+  // mix(), by input length.
+  uint64_t len_0_to_16 = 0;
+  uint64_t len_17_to_32 = 0;
+  uint64_t len_33_to_64 = 0;
+  // Hashes finalized by final_mix(), i.e. with inputs over 64 bytes.
+  uint64_t final_mixes = 0;
+  // Calls to mix(), each of which consumes 64 bytes.
+  uint64_t mixes = 0;
+  // Calls to hash_combine_range() on bytes, and the bytes they passed.
+  uint64_t ranges = 0;
+  uint64_t bytes = 0;
+  // Histogram of the sizes passed to hash_combine_range(): bucket 0 counts
+  // empty ranges, bucket i counts sizes in [2^(i-1), 2^i), and the last
+  // bucket also counts everything larger.
+  std::array<uint64_t, kNumSizeBuckets> range_sizes = {};
+
+  uint64_t hashes() const {
+    return len_0_to_16 + len_17_to_32 + len_33_to_64 + final_mixes;
+  }
+
+  static size_t size_bucket(size_t size) {
+    size_t bucket = 0;
+    while (size != 0 && bucket + 1 < kNumSizeBuckets) {
+      size >>= 1;
+      ++bucket;
+    }
+    return bucket;
+  }
+
+  // Returns the current totals. Counts from other threads that are still
+  // running may lag slightly.
+  static farmhash_counters snapshot();
+
+  // Returns the counts accumulated between two snapshots.
+  friend farmhash_counters operator-(farmhash_counters lhs,
+                                     const farmhash_counters& rhs) {
+    lhs.len_0_to_16 -= rhs.len_0_to_16;
+    lhs.len_17_to_32 -= rhs.len_17_to_32;
+    lhs.len_33_to_64 -= rhs.len_33_to_64;
+    lhs.final_mixes -= rhs.final_mixes;
+    lhs.mixes -= rhs.mixes;
+    lhs.ranges -= rhs.ranges;
+    lhs.bytes -= rhs.bytes;
+    for (size_t i = 0; i < kNumSizeBuckets; ++i) {
+      lhs.range_sizes[i] -= rhs.range_sizes[i];
+    }
+    return lhs;
+  }
+};
+
+namespace detail {
+
+// Per-thread storage for farmhash_counters. Each counter is only written by
+// its own thread, so a relaxed load and store suffices to increment it,
+// which costs the same as a plain increment, while letting snapshot()
+// read it concurrently.
+class farmhash_thread_counters {
+ public:
+  enum counter {
+    kLen0To16,
+    kLen17To32,
+    kLen33To64,
+    kFinalMixes,
+    kMixes,
+    kRanges,
+    kBytes,
+    kRangeSizes,
+    kNumCounters = kRangeSizes + farmhash_counters::kNumSizeBuckets
+  };
+
+  static farmhash_thread_counters& get() {
+    thread_local farmhash_thread_counters counters;
+    return counters;
+  }
+
+  void add(counter c, uint64_t n) {
+    counts_[c].store(counts_[c].load(std::memory_order_relaxed) + n,
+                     std::memory_order_relaxed);
+  }
+
+  static farmhash_counters snapshot() {
+    registry& r = get_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::array<uint64_t, kNumCounters> totals = r.retired;
+    for (const farmhash_thread_counters* counters : r.live) {
+      for (size_t i = 0; i < kNumCounters; ++i) {
+        totals[i] += counters->counts_[i].load(std::memory_order_relaxed);
+      }
+    }
+    farmhash_counters result;
+    result.len_0_to_16 = totals[kLen0To16];
+    result.len_17_to_32 = totals[kLen17To32];
+    result.len_33_to_64 = totals[kLen33To64];
+    result.final_mixes = totals[kFinalMixes];
+    result.mixes = totals[kMixes];
+    result.ranges = totals[kRanges];
+    result.bytes = totals[kBytes];
+    for (size_t i = 0; i < farmhash_counters::kNumSizeBuckets; ++i) {
+      result.range_sizes[i] = totals[kRangeSizes + i];
+    }
+    return result;
+  }
+
+ private:
+  // The counters of all running threads, and the totals of exited ones.
+  struct registry {
+    std::mutex mutex;
+    std::vector<const farmhash_thread_counters*> live;
+    std::array<uint64_t, kNumCounters> retired = {};
+  };
+
+  static registry& get_registry() {
+    static registry* r = new registry;
+    return *r;
+  }
+
+  farmhash_thread_counters() {
+    for (auto& count : counts_) count.store(0, std::memory_order_relaxed);
+    registry& r = get_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.live.push_back(this);
+  }
+
+  ~farmhash_thread_counters() {
+    registry& r = get_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (size_t i = 0; i < kNumCounters; ++i) {
+      r.retired[i] += counts_[i].load(std::memory_order_relaxed);
+    }
+    for (auto& live : r.live) {
+      if (live == this) {
+        live = r.live.back();
+        r.live.pop_back();
+        break;
+      }
+    }
+  }
+
+  std::atomic<uint64_t> counts_[kNumCounters];
+};
+
+// The hooks called by farmhash.
+inline void farmhash_count(farmhash_thread_counters::counter c) {
+  if constexpr (farmhash_counters::kEnabled) {
+    farmhash_thread_counters::get().add(c, 1);
+  }
+}
+
+inline void farmhash_count_range(size_t size) {
+  if constexpr (farmhash_counters::kEnabled) {
+    farmhash_thread_counters& counters = farmhash_thread_counters::get();
+    counters.add(farmhash_thread_counters::kRanges, 1);
+    counters.add(farmhash_thread_counters::kBytes, size);
+    counters.add(static_cast<farmhash_thread_counters::counter>(
+                     farmhash_thread_counters::kRangeSizes +
+                     farmhash_counters::size_bucket(size)),
+                 1);
+  }
+}
+
+}  // namespace detail
+
+inline farmhash_counters farmhash_counters::snapshot() {
+  if constexpr (kEnabled) {
+    return detail::farmhash_thread_counters::snapshot();
+  } else {
+    return farmhash_counters();
+  }
+}
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_FARMHASH_COUNTERS_H
@@ -0,0 +1,94 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Built with HASHING_DEMO_FARMHASH_COUNTERS=1; see CMakeLists.txt.
+
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "farmhash.h"
+#include "std.h"
+
+namespace {
+
+using ::hashing::farmhash_counters;
+
+size_t HashString(const std::string& s) {
+  return std_::hash<std::string>{}(s);
+}
+
+TEST(FarmhashCountersTest, Enabled) {
+  EXPECT_TRUE(farmhash_counters::kEnabled);
+}
+
+TEST(FarmhashCountersTest, CountsShortPaths) {
+  const farmhash_counters before = farmhash_counters::snapshot();
+  // The string's size is also hashed, so these are 8 bytes longer.
+  HashString(std::string(4, 'a'));
+  HashString(std::string(20, 'a'));
+  HashString(std::string(40, 'a'));
+  const farmhash_counters delta = farmhash_counters::snapshot() - before;
+
+  EXPECT_EQ(1u, delta.len_0_to_16);
+  EXPECT_EQ(1u, delta.len_17_to_32);
+  EXPECT_EQ(1u, delta.len_33_to_64);
+  EXPECT_EQ(0u, delta.final_mixes);
+  EXPECT_EQ(0u, delta.mixes);
+  EXPECT_EQ(3u, delta.hashes());
+  EXPECT_EQ(6u, delta.ranges);
+  EXPECT_EQ(4 + 20 + 40 + 3 * sizeof(size_t), delta.bytes);
+}
+
+TEST(FarmhashCountersTest, CountsMixes) {
+  const farmhash_counters before = farmhash_counters::snapshot();
+  // 200 bytes of characters plus 8 of size: three full 64-byte blocks are
+  // mixed, and the remaining 16 bytes are left for final_mix().
+  HashString(std::string(200, 'a'));
+  const farmhash_counters delta = farmhash_counters::snapshot() - before;
+
+  EXPECT_EQ(1u, delta.final_mixes);
+  EXPECT_EQ(3u, delta.mixes);
+  EXPECT_EQ(1u, delta.hashes());
+}
+
+TEST(FarmhashCountersTest, RangeSizeHistogram) {
+  EXPECT_EQ(0u, farmhash_counters::size_bucket(0));
+  EXPECT_EQ(1u, farmhash_counters::size_bucket(1));
+  EXPECT_EQ(2u, farmhash_counters::size_bucket(2));
+  EXPECT_EQ(2u, farmhash_counters::size_bucket(3));
+  EXPECT_EQ(4u, farmhash_counters::size_bucket(8));
+  EXPECT_EQ(farmhash_counters::kNumSizeBuckets - 1,
+            farmhash_counters::size_bucket(size_t(1) << 40));
+
+  const farmhash_counters before = farmhash_counters::snapshot();
+  HashString(std::string(100, 'a'));
+  const farmhash_counters delta = farmhash_counters::snapshot() - before;
+  EXPECT_EQ(1u, delta.range_sizes[farmhash_counters::size_bucket(100)]);
+  EXPECT_EQ(1u, delta.range_sizes[farmhash_counters::size_bucket(8)]);
+}
+
+TEST(FarmhashCountersTest, IncludesOtherThreads) {
+  const farmhash_counters before = farmhash_counters::snapshot();
+  std::thread thread([] {
+    for (int i = 0; i < 10; ++i) HashString("hello");
+  });
+  thread.join();
+  // The thread has exited, so its counts have been retired.
+  const farmhash_counters delta = farmhash_counters::snapshot() - before;
+  EXPECT_EQ(10u, delta.len_0_to_16);
+}
+
+}  // namespace
@@ -0,0 +1,114 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "bloom_filter.h"
+#include "cuckoo_filter.h"
+
+namespace {
+
+static const int kNumKeys = 10000;
+
+TEST(BlockedBloomFilterTest, NoFalseNegatives) {
+  hashing::blocked_bloom_filter<std::string> filter(kNumKeys);
+  for (int i = 0; i < kNumKeys; ++i) {
+    filter.insert(std::to_string(i));
+  }
+  for (int i = 0; i < kNumKeys; ++i) {
+    EXPECT_TRUE(filter.possibly_contains(std::to_string(i))) << i;
+  }
+}
+
+TEST(BlockedBloomFilterTest, FalsePositiveRate) {
+  hashing::blocked_bloom_filter<int> filter(kNumKeys, 10.0);
+  EXPECT_EQ(7, filter.num_probes());
+  for (int i = 0; i < kNumKeys; ++i) {
+    filter.insert(i);
+  }
+  int false_positives = 0;
+  for (int i = kNumKeys; i < 11 * kNumKeys; ++i) {
+    false_positives += filter.possibly_contains(i);
+  }
+  // A standard Bloom filter at 10 bits/key has a 0.8% false-positive rate;
+  // blocking costs a little accuracy.
+  EXPECT_LT(false_positives, 0.02 * 10 * kNumKeys);
+}
+
+TEST(BlockedBloomFilterTest, Merge) {
+  hashing::blocked_bloom_filter<int> a(kNumKeys), b(kNumKeys);
+  for (int i = 0; i < kNumKeys; ++i) {
+    (i % 2 ? a : b).insert(i);
+  }
+  a.merge(b);
+  for (int i = 0; i < kNumKeys; ++i) {
+    EXPECT_TRUE(a.possibly_contains(i)) << i;
+  }
+}
+
+TEST(CuckooFilterTest, NoFalseNegatives) {
+  hashing::cuckoo_filter<std::string> filter(kNumKeys);
+  for (int i = 0; i < kNumKeys; ++i) {
+    EXPECT_TRUE(filter.insert(std::to_string(i))) << i;
+  }
+  EXPECT_EQ(size_t{kNumKeys}, filter.size());
+  for (int i = 0; i < kNumKeys; ++i) {
+    EXPECT_TRUE(filter.possibly_contains(std::to_string(i))) << i;
+  }
+}
+
+TEST(CuckooFilterTest, FalsePositiveRate) {
+  hashing::cuckoo_filter<int> filter(kNumKeys);
+  for (int i = 0; i < kNumKeys; ++i) {
+    filter.insert(i);
+  }
+  int false_positives = 0;
+  for (int i = kNumKeys; i < 11 * kNumKeys; ++i) {
+    false_positives += filter.possibly_contains(i);
+  }
+  // The expected rate with 16-bit fingerprints and 4-way buckets is
+  // about 8 / 2^16.
+  EXPECT_LT(false_positives, 0.001 * 10 * kNumKeys);
+}
+
+TEST(CuckooFilterTest, Erase) {
+  hashing::cuckoo_filter<int> filter(kNumKeys);
+  for (int i = 0; i < kNumKeys; ++i) {
+    filter.insert(i);
+  }
+  for (int i = 0; i < kNumKeys; i += 2) {
+    EXPECT_TRUE(filter.erase(i)) << i;
+  }
+  EXPECT_EQ(size_t{kNumKeys / 2}, filter.size());
+  for (int i = 1; i < kNumKeys; i += 2) {
+    EXPECT_TRUE(filter.possibly_contains(i)) << i;
+  }
+}
+
+TEST(CuckooFilterTest, RejectsInsertionsWhenFull) {
+  hashing::cuckoo_filter<int> filter(100);
+  int inserted = 0;
+  while (filter.insert(inserted)) {
+    ++inserted;
+    ASSERT_LE(inserted, 2 * filter.capacity());
+  }
+  EXPECT_GE(inserted, 0.9 * filter.capacity());
+  for (int i = 0; i < inserted; ++i) {
+    EXPECT_TRUE(filter.possibly_contains(i)) << i;
+  }
+}
+
+}  // namespace
@@ -15,6 +15,11 @@
 #ifndef HASHING_DEMO_FNV1A_H
 #define HASHING_DEMO_FNV1A_H
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
 #include "std_impl.h"
 
 namespace hashing {
@@ -68,11 +73,12 @@ class fnv1a {
               typename std::iterator_traits<InputIterator>::value_type>::value,
       fnv1a>
   hash_combine_range(fnv1a hash_code, InputIterator begin, InputIterator end) {
-    using std_::adl_pointer_from;
+    const auto pointers =
+        std_::detail::contiguous_range_pointers(begin, end);
     const unsigned char* begin_ptr =
-        reinterpret_cast<const unsigned char*>(adl_pointer_from(begin));
+        reinterpret_cast<const unsigned char*>(pointers.first);
     const unsigned char* end_ptr =
-        reinterpret_cast<const unsigned char*>(adl_pointer_from(end));
+        reinterpret_cast<const unsigned char*>(pointers.second);
     return hash_combine_range(hash_code, begin_ptr, end_ptr);
   }
 
@@ -170,6 +176,155 @@ class type_invariant_fnv1a {
   }
 };
 
+// FNV-style hash that processes its input kLanes * 8 bytes at a time, with
+// one multiply per 8 bytes, instead of one per byte. Each lane is an
+// independent FNV-1a-like state that mixes in a 64-bit word with an xor
+// and a multiply by the FNV prime, followed by a rotation so that the high
+// bits of each word reach the low bits of the state. With several lanes,
+// the multiplies are independent and can overlap in the pipeline. At the
+// end, the lanes are folded into one state, the remaining bytes and the
+// total length are mixed in, and the result is finalized with a
+// MurmurHash3-style avalanche.
+//
+// Partial blocks are buffered, so the result depends only on the sequence
+// of bytes, not on how it was split into hash_combine_range() calls, just
+// as for fnv1a. The results are not compatible with fnv1a, and depend on
+// the platform's byte order.
+template <int kLanes>
+class basic_fnv1a_lanes {
+  static constexpr size_t kBlockSize = 8 * kLanes;
+
+ public:
+  class state_type;
+  using result_type = size_t;
+
+  // Move only. The lanes and the pending partial block are kept in a
+  // state_type owned by the caller, as for farmhash, so that passing the
+  // HashCode by value through every hash_combine() step copies a pointer
+  // rather than kBlockSize + kLanes * 8 bytes of state.
+  basic_fnv1a_lanes(const basic_fnv1a_lanes&) = delete;
+  basic_fnv1a_lanes& operator=(const basic_fnv1a_lanes&) = delete;
+  basic_fnv1a_lanes(basic_fnv1a_lanes&&) = default;
+  basic_fnv1a_lanes& operator=(basic_fnv1a_lanes&&) = default;
+
+  // Constructs a basic_fnv1a_lanes that hashes into 'state', which must
+  // outlive it and must not be shared with another HashCode.
+  explicit basic_fnv1a_lanes(state_type* state) : state_(state) {}
+
+  template <typename T, typename... Ts>
+  friend basic_fnv1a_lanes hash_combine(basic_fnv1a_lanes hash_code,
+                                        const T& value, const Ts&... values) {
+    return hash_combine(
+        std_::simple_hash_combine(std::move(hash_code), value), values...);
+  }
+
+  friend basic_fnv1a_lanes hash_combine(basic_fnv1a_lanes hash_code) {
+    return hash_code;
+  }
+
+  template <typename InputIterator>
+  friend basic_fnv1a_lanes hash_combine_range(
+      basic_fnv1a_lanes hash_code, InputIterator begin, InputIterator end) {
+    return std_::simple_hash_combine_range(std::move(hash_code), begin, end);
+  }
+
+  friend basic_fnv1a_lanes hash_combine_range(
+      basic_fnv1a_lanes hash_code, const unsigned char* begin,
+      const unsigned char* end) {
+    hash_code.combine(begin, end);
+    return hash_code;
+  }
+
+  explicit operator result_type() && noexcept {
+    return state_->finalize();
+  }
+
+ private:
+  void combine(const unsigned char* begin, const unsigned char* end) {
+    state_->combine(begin, end);
+  }
+
+  state_type* state_;
+};
+
+template <int kLanes>
+class basic_fnv1a_lanes<kLanes>::state_type {
+ public:
+  state_type() {
+    for (int i = 0; i < kLanes; ++i) {
+      lanes_[i] = 14695981039346656037u + i * 0x9e3779b97f4a7c15u;
+    }
+  }
+
+  // Non-copyable and non-movable, since a basic_fnv1a_lanes points to it.
+  state_type(const state_type&) = delete;
+  state_type& operator=(const state_type&) = delete;
+
+ private:
+  friend class basic_fnv1a_lanes;
+
+  void combine(const unsigned char* begin, const unsigned char* end) {
+    length_ += end - begin;
+    if (pending_size_ != 0) {
+      const size_t n =
+          std::min<size_t>(kBlockSize - pending_size_, end - begin);
+      std::memcpy(pending_ + pending_size_, begin, n);
+      pending_size_ += n;
+      begin += n;
+      if (pending_size_ < kBlockSize) return;
+      mix_block(pending_);
+      pending_size_ = 0;
+    }
+    while (size_t(end - begin) >= kBlockSize) {
+      mix_block(begin);
+      begin += kBlockSize;
+    }
+    std::memcpy(pending_, begin, end - begin);
+    pending_size_ = end - begin;
+  }
+
+  result_type finalize() const {
+    uint64_t h = lanes_[0];
+    for (int i = 1; i < kLanes; ++i) {
+      h = mix(h, lanes_[i]);
+    }
+    for (size_t i = 0; i < pending_size_; i += 8) {
+      uint64_t word = 0;
+      std::memcpy(&word, pending_ + i, std::min<size_t>(8, pending_size_ - i));
+      h = mix(h, word);
+    }
+    h = mix(h, length_);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdu;
+    h ^= h >> 33;
+    return h;
+  }
+
+  static uint64_t mix(uint64_t state, uint64_t word) {
+    state = (state ^ word) * 1099511628211u;
+    return (state << 31) | (state >> 33);
+  }
+
+  void mix_block(const unsigned char* block) {
+    for (int i = 0; i < kLanes; ++i) {
+      uint64_t word;
+      std::memcpy(&word, block + 8 * i, 8);
+      lanes_[i] = mix(lanes_[i], word);
+    }
+  }
+
+  uint64_t lanes_[kLanes];
+  unsigned char pending_[kBlockSize];
+  size_t pending_size_ = 0;
+  uint64_t length_ = 0;
+};
+
+// Processes 8 bytes at a time in a single lane.
+using fnv1a_word = basic_fnv1a_lanes<1>;
+
+// Processes 32 bytes at a time in 4 independent lanes.
+using fnv1a_4lane = basic_fnv1a_lanes<4>;
+
 }  // namespace hashing
 
 #endif  // HASHING_DEMO_FNV1A_H
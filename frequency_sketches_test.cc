@@ -0,0 +1,165 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "count_min_sketch.h"
+#include "space_saving.h"
+
+namespace {
+
+// Returns a Zipf-like stream over 'num_keys' keys, in which key i occurs
+// roughly proportionally to 1 / (i + 1).
+std::vector<int> SkewedStream(int num_keys, int length) {
+  std::vector<double> weights(num_keys);
+  for (int i = 0; i < num_keys; ++i) {
+    weights[i] = 1.0 / (i + 1);
+  }
+  std::discrete_distribution<int> dist(weights.begin(), weights.end());
+  std::default_random_engine engine;
+  std::vector<int> stream(length);
+  for (int& key : stream) {
+    key = dist(engine);
+  }
+  return stream;
+}
+
+std::map<int, uint64_t> ExactCounts(const std::vector<int>& stream) {
+  std::map<int, uint64_t> counts;
+  for (int key : stream) {
+    ++counts[key];
+  }
+  return counts;
+}
+
+using CountMin = hashing::count_min_sketch<int>;
+
+TEST(CountMinSketchTest, NeverUndercounts) {
+  const std::vector<int> stream = SkewedStream(10000, 100000);
+  const std::map<int, uint64_t> exact = ExactCounts(stream);
+  CountMin standard(1024, 4);
+  CountMin conservative(1024, 4, CountMin::update_policy::conservative);
+  for (int key : stream) {
+    standard.add(key);
+    conservative.add(key);
+  }
+  EXPECT_EQ(stream.size(), standard.total_count());
+  uint64_t standard_error = 0, conservative_error = 0;
+  for (const auto& p : exact) {
+    ASSERT_GE(standard.estimate(p.first), p.second) << p.first;
+    ASSERT_GE(conservative.estimate(p.first), p.second) << p.first;
+    ASSERT_LE(conservative.estimate(p.first), standard.estimate(p.first));
+    standard_error += standard.estimate(p.first) - p.second;
+    conservative_error += conservative.estimate(p.first) - p.second;
+  }
+  EXPECT_LT(conservative_error, standard_error);
+}
+
+TEST(CountMinSketchTest, ErrorBound) {
+  const std::vector<int> stream = SkewedStream(10000, 100000);
+  const std::map<int, uint64_t> exact = ExactCounts(stream);
+  CountMin sketch(2718, 5);
+  for (int key : stream) {
+    sketch.add(key);
+  }
+  // With width e/0.001, estimates are within 0.1% of the stream length
+  // with probability 1 - e^-5 per key.
+  int violations = 0;
+  for (const auto& p : exact) {
+    violations += sketch.estimate(p.first) > p.second + stream.size() / 1000;
+  }
+  EXPECT_LT(violations, 0.01 * exact.size());
+}
+
+TEST(CountMinSketchTest, MergeEqualsCombinedStream) {
+  const std::vector<int> stream = SkewedStream(1000, 10000);
+  CountMin all(256, 4), first(256, 4), second(256, 4);
+  for (size_t i = 0; i < stream.size(); ++i) {
+    all.add(stream[i]);
+    (i % 2 ? first : second).add(stream[i]);
+  }
+  first.merge(second);
+  EXPECT_EQ(all.total_count(), first.total_count());
+  for (int key = 0; key < 1000; ++key) {
+    EXPECT_EQ(all.estimate(key), first.estimate(key)) << key;
+  }
+}
+
+TEST(CountMinSketchTest, StringKeys) {
+  hashing::count_min_sketch<std::string> sketch(64, 3);
+  sketch.add("foo", 3);
+  sketch.add("bar");
+  EXPECT_GE(sketch.estimate("foo"), 3u);
+  EXPECT_GE(sketch.estimate("bar"), 1u);
+}
+
+TEST(SpaceSavingTest, ExactWhileUnderCapacity) {
+  hashing::space_saving<std::string> top(10);
+  top.add("a", 5);
+  top.add("b", 3);
+  top.add("c");
+  top.add("a");
+  auto result = top.top(2);
+  ASSERT_EQ(2u, result.size());
+  EXPECT_EQ("a", result[0].key);
+  EXPECT_EQ(6u, result[0].count);
+  EXPECT_EQ(0u, result[0].error);
+  EXPECT_EQ("b", result[1].key);
+  EXPECT_EQ(3u, result[1].count);
+  EXPECT_EQ(3u, top.size());
+}
+
+TEST(SpaceSavingTest, FindsHeavyHitters) {
+  const std::vector<int> stream = SkewedStream(100000, 200000);
+  const std::map<int, uint64_t> exact = ExactCounts(stream);
+  hashing::space_saving<int> top(100);
+  for (int key : stream) {
+    top.add(key);
+  }
+  EXPECT_EQ(100u, top.size());
+  for (const auto& e : top.top(100)) {
+    auto it = exact.find(e.key);
+    const uint64_t true_count = it == exact.end() ? 0 : it->second;
+    EXPECT_GE(e.count, true_count) << e.key;
+    EXPECT_LE(e.count - e.error, true_count) << e.key;
+  }
+  // Every key above total/capacity must be tracked, and the five hottest
+  // keys come out in order.
+  const auto result = top.top(5);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(i, result[i].key);
+  }
+}
+
+TEST(SpaceSavingTest, Merge) {
+  const std::vector<int> stream = SkewedStream(100000, 200000);
+  hashing::space_saving<int> first(100), second(100);
+  for (size_t i = 0; i < stream.size(); ++i) {
+    (i % 2 ? first : second).add(stream[i]);
+  }
+  first.merge(second);
+  EXPECT_EQ(stream.size(), first.total_count());
+  EXPECT_EQ(100u, first.size());
+  const auto result = first.top(5);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(i, result[i].key);
+  }
+}
+
+}  // namespace
@@ -0,0 +1,66 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Small helpers shared by the demo data structures and the benchmarks. Not
+// part of this proposal.
+
+#ifndef HASHING_DEMO_HASH_UTIL_H
+#define HASHING_DEMO_HASH_UTIL_H
+
+#include <cstdint>
+#include <type_traits>
+
+#include "std_impl.h"
+
+namespace hashing {
+
+// The SplitMix64 output function: a cheap bijection on 64 bits whose
+// outputs for consecutive inputs look unrelated.
+constexpr uint64_t splitmix64_mix(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// Advances the SplitMix64 generator state '*state' and returns its next
+// output. Much cheaper than the <random> engines, for when statistical
+// quality matters less than speed or constexpr-ness.
+constexpr uint64_t splitmix64(uint64_t* state) {
+  return splitmix64_mix(*state += 0x9e3779b97f4a7c15ULL);
+}
+
+// Hash functor that hashes with a HashCode that is either
+// default-constructible, or constructed from a pointer to a state_type like
+// farmhash.
+template <typename HashCode, typename T, typename = void>
+struct hash_code_hasher {
+  typename HashCode::result_type operator()(const T& t) const {
+    using std_::hash_value;
+    return typename HashCode::result_type(hash_value(HashCode(), t));
+  }
+};
+
+template <typename HashCode, typename T>
+struct hash_code_hasher<HashCode, T,
+                        std::void_t<typename HashCode::state_type>> {
+  typename HashCode::result_type operator()(const T& t) const {
+    using std_::hash_value;
+    typename HashCode::state_type state;
+    return typename HashCode::result_type(hash_value(HashCode(&state), t));
+  }
+};
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_HASH_UTIL_H
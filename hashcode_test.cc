@@ -15,6 +15,7 @@
 // Type-parameterized hash algorithm tests.
 
 #include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <limits>
 #include <numeric>
@@ -27,8 +28,12 @@
 #include "debug.h"
 #include "farmhash.h"
 #include "fnv1a.h"
+#include "n3980-farmhash.h"
+#include "n3980_adapters.h"
 #include "pimpl.h"
+#include "rolling_hash.h"
 #include "std.h"
+#include "type_erased_hash_code.h"
 
 namespace {
 
@@ -54,6 +59,26 @@ struct HashHelper<hashing::farmhash, T> {
   }
 };
 
+template <int kLanes, typename T>
+struct HashHelper<hashing::basic_fnv1a_lanes<kLanes>, T> {
+  static size_t Hash(const T& t) {
+    using std_::hash_value;
+    using HashCode = hashing::basic_fnv1a_lanes<kLanes>;
+    typename HashCode::state_type state;
+    return size_t(hash_value(HashCode(&state), t));
+  }
+};
+
+template <typename HashAlgorithm, typename T>
+struct HashHelper<hashing::hash_code_adapter<HashAlgorithm>, T> {
+  static typename HashAlgorithm::result_type Hash(const T& t) {
+    using std_::hash_value;
+    using HashCode = hashing::hash_code_adapter<HashAlgorithm>;
+    typename HashCode::state_type state;
+    return typename HashCode::result_type(hash_value(HashCode(&state), t));
+  }
+};
+
 template <typename HashCode>
 class HashCodeTest : public ::testing::Test {
  public:
@@ -66,6 +91,17 @@ class HashCodeTest : public ::testing::Test {
   void HashCombineIntegralTypeImpl();
 };
 
+// Pimpl's hash_value() skips type erasure only for farmhash.
+static_assert(std_::hashing_strategy<Pimpl, hashing::farmhash>::value ==
+                  std_::hash_strategy::per_field,
+              "");
+static_assert(std_::hashing_strategy<Pimpl, hashing::fnv1a>::value ==
+                  std_::hash_strategy::type_erased,
+              "");
+static_assert(std_::hashing_strategy<WidePimpl, hashing::fnv1a>::value ==
+                  std_::hash_strategy::type_erased,
+              "");
+
 TYPED_TEST_CASE_P(HashCodeTest);
 
 // Hashable types
@@ -222,15 +258,45 @@ TYPED_TEST_P(HashCodeTest, HashPimplType) {
   EXPECT_EQ(this->Hash(EquivalentToPimpl{}), this->Hash(Pimpl{}));
 }
 
+// WidePimpl's input exceeds type_erased_hash_code's buffer, and is split
+// differently when forwarded to the HashCode.
+TYPED_TEST_P(HashCodeTest, HashWidePimplType) {
+  EXPECT_EQ(this->Hash(WideFields{}), this->Hash(WidePimpl{}));
+}
+
 REGISTER_TYPED_TEST_CASE_P(HashCodeTest,
                            NoOpsAreEquivalent,
                            HashCombineIntegralType,
                            HashNonUniquelyRepresentedType,
-                           HashPimplType);
+                           HashPimplType,
+                           HashWidePimplType);
 
 using HashCodeTypes = ::testing::Types<
-  hashing::farmhash, hashing::fnv1a, hashing::type_invariant_fnv1a,
-  hashing::identity>;
+  hashing::farmhash, hashing::fnv1a, hashing::fnv1a_word,
+  hashing::fnv1a_4lane, hashing::type_invariant_fnv1a, hashing::identity,
+  hashing::gear_hash, hashing::hash_code_adapter<hashing::n3980::farmhash>>;
+
+size_t ExpectedTypeErasedHash() {
+  return size_t(hash_combine(hashing::fnv1a(), 42, std::string(300, 'x')));
+}
+
+TEST(TypeErasedHashCodeTest, UnbufferedForwardsEachRange) {
+  hashing::fnv1a code;
+  hash_combine(hashing::type_erased_hash_code(&code), 42,
+               std::string(300, 'x'));
+  EXPECT_EQ(ExpectedTypeErasedHash(), size_t(std::move(code)));
+}
+
+TEST(TypeErasedHashCodeTest, BufferFlushesOnDestruction) {
+  hashing::fnv1a code;
+  {
+    hashing::type_erased_hash_code::buffer buffer(&code);
+    // Leaves the 8-byte size of the string in the buffer.
+    hash_combine(hashing::type_erased_hash_code(&buffer), 42,
+                 std::string(300, 'x'));
+  }
+  EXPECT_EQ(ExpectedTypeErasedHash(), size_t(std::move(code)));
+}
 INSTANTIATE_TYPED_TEST_CASE_P(My, HashCodeTest, HashCodeTypes);
 
 }  // namespace
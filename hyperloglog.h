@@ -0,0 +1,348 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// HyperLogLog++ cardinality estimator (Heule et al., "HyperLogLog in
+// Practice") for any type that std_::hash supports. Not part of this
+// proposal.
+
+#ifndef HASHING_DEMO_HYPERLOGLOG_H
+#define HASHING_DEMO_HYPERLOGLOG_H
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "std.h"
+
+namespace hashing {
+
+// Estimates the number of distinct values inserted into it, using
+// 2^precision bytes of memory or less. Sketches with the same precision
+// can be merged, and the result is the sketch of the union of their
+// inputs, so per-thread or per-shard sketches can be built independently.
+//
+// Small sketches use the sparse representation of HLL++: a sorted list of
+// (index, rank) pairs at precision 25, which gives near-exact counts until
+// the list grows as large as the dense register array. The empirical bias
+// correction tables of HLL++ are omitted; in the range where they matter,
+// the dense estimate falls back to linear counting, as in the original
+// HyperLogLog.
+template <typename T, typename Hash = std_::hash<T>>
+class hyperloglog {
+ public:
+  static constexpr int kMinPrecision = 4;
+  static constexpr int kMaxPrecision = 18;
+  static constexpr int kSparsePrecision = 25;
+
+  explicit hyperloglog(int precision = 14, Hash hash = Hash())
+      : precision_(precision), hash_(std::move(hash)) {
+    assert(precision >= kMinPrecision && precision <= kMaxPrecision);
+  }
+
+  void insert(const T& value) { insert_hash(hash_(value)); }
+
+  // Variant of insert() that takes a precomputed hash value.
+  void insert_hash(uint64_t hash) {
+    if (!is_sparse()) {
+      uint8_t rank = rank_of(hash, precision_);
+      uint8_t& reg = registers_[hash >> (64 - precision_)];
+      reg = std::max(reg, rank);
+      return;
+    }
+    buffer_.push_back(sparse_entry(hash));
+    if (buffer_.size() >= buffer_limit()) {
+      flush_buffer();
+    }
+  }
+
+  // Merges 'other' into this sketch. Both must have the same precision.
+  void merge(const hyperloglog& other) {
+    assert(precision_ == other.precision_);
+    if (&other == this) return;
+    if (other.is_sparse()) {
+      if (is_sparse()) {
+        buffer_.insert(buffer_.end(), other.sparse_.begin(),
+                       other.sparse_.end());
+        buffer_.insert(buffer_.end(), other.buffer_.begin(),
+                       other.buffer_.end());
+        flush_buffer();
+      } else {
+        for (uint32_t entry : other.sparse_) merge_into_registers(entry);
+        for (uint32_t entry : other.buffer_) merge_into_registers(entry);
+      }
+      return;
+    }
+    if (is_sparse()) convert_to_dense();
+    // A plain element-wise max over byte arrays, which compilers turn into
+    // packed-byte max instructions.
+    uint8_t* dst = registers_.data();
+    const uint8_t* src = other.registers_.data();
+    for (size_t i = 0, n = registers_.size(); i < n; ++i) {
+      dst[i] = std::max(dst[i], src[i]);
+    }
+  }
+
+  // Returns the estimated number of distinct values inserted.
+  double estimate() const {
+    if (is_sparse()) {
+      // Linear counting over the 2^25 virtual registers of the sparse
+      // representation.
+      const double m = double(uint64_t{1} << kSparsePrecision);
+      const double n = double(merged_sparse_entries().size());
+      return m * std::log(m / (m - n));
+    }
+    const double m = double(registers_.size());
+    double sum = 0;
+    size_t zeros = 0;
+    for (uint8_t reg : registers_) {
+      sum += std::ldexp(1.0, -reg);
+      zeros += (reg == 0);
+    }
+    const double raw = alpha(registers_.size()) * m * m / sum;
+    if (zeros != 0 && raw <= 2.5 * m) {
+      return m * std::log(m / double(zeros));
+    }
+    return raw;
+  }
+
+  bool is_sparse() const { return registers_.empty(); }
+  int precision() const { return precision_; }
+
+  // Returns a compact serialized form of the sketch. The format is
+  //   byte 0:  kSparseFormat or kDenseFormat
+  //   byte 1:  precision
+  // followed, for sparse sketches, by the entry count and the sorted
+  // entries as delta-encoded base-128 varints, and for dense sketches by
+  // the registers, packed 6 bits each in little-endian bit order.
+  std::string serialize() const {
+    std::string out;
+    if (is_sparse()) {
+      std::vector<uint32_t> entries = merged_sparse_entries();
+      out.push_back(char(kSparseFormat));
+      out.push_back(char(precision_));
+      append_varint(&out, entries.size());
+      uint32_t previous = 0;
+      for (uint32_t entry : entries) {
+        append_varint(&out, entry - previous);
+        previous = entry;
+      }
+    } else {
+      out.push_back(char(kDenseFormat));
+      out.push_back(char(precision_));
+      uint32_t bits = 0;
+      int num_bits = 0;
+      for (uint8_t reg : registers_) {
+        bits |= uint32_t{reg} << num_bits;
+        num_bits += 6;
+        while (num_bits >= 8) {
+          out.push_back(char(bits & 0xff));
+          bits >>= 8;
+          num_bits -= 8;
+        }
+      }
+    }
+    return out;
+  }
+
+  // Replaces the contents of this sketch with the sketch serialized in
+  // 'bytes'. Returns false, leaving the sketch unchanged, if 'bytes' is
+  // not a valid serialized sketch.
+  bool deserialize(const std::string& bytes) {
+    if (bytes.size() < 2) return false;
+    const int format = static_cast<unsigned char>(bytes[0]);
+    const int precision = static_cast<unsigned char>(bytes[1]);
+    if (precision < kMinPrecision || precision > kMaxPrecision) return false;
+    const unsigned char* p =
+        reinterpret_cast<const unsigned char*>(bytes.data()) + 2;
+    const unsigned char* end =
+        reinterpret_cast<const unsigned char*>(bytes.data()) + bytes.size();
+
+    if (format == kSparseFormat) {
+      uint64_t count;
+      if (!parse_varint(&p, end, &count) || count > size_t(end - p)) {
+        return false;
+      }
+      std::vector<uint32_t> entries;
+      entries.reserve(count);
+      uint64_t entry = 0;
+      for (uint64_t i = 0; i < count; ++i) {
+        uint64_t delta;
+        if (!parse_varint(&p, end, &delta)) return false;
+        const uint64_t previous = entry;
+        entry += delta;
+        // Entries must be sorted, with one entry per index.
+        const uint64_t rank = entry & 63;
+        if ((i != 0 && (entry >> 6) <= (previous >> 6)) ||
+            (entry >> 6) >= (uint64_t{1} << kSparsePrecision) || rank == 0 ||
+            rank > 64 - kSparsePrecision + 1) {
+          return false;
+        }
+        entries.push_back(uint32_t(entry));
+      }
+      if (p != end) return false;
+      precision_ = precision;
+      registers_.clear();
+      buffer_.clear();
+      sparse_ = std::move(entries);
+      if (sparse_.size() > sparse_limit()) convert_to_dense();
+      return true;
+    }
+
+    if (format == kDenseFormat) {
+      const size_t m = size_t{1} << precision;
+      if (size_t(end - p) != m * 6 / 8) return false;
+      std::vector<uint8_t> registers(m);
+      uint32_t bits = 0;
+      int num_bits = 0;
+      for (uint8_t& reg : registers) {
+        while (num_bits < 6) {
+          bits |= uint32_t{*p++} << num_bits;
+          num_bits += 8;
+        }
+        reg = bits & 63;
+        bits >>= 6;
+        num_bits -= 6;
+        if (reg > 64 - precision + 1) return false;
+      }
+      precision_ = precision;
+      sparse_.clear();
+      buffer_.clear();
+      registers_ = std::move(registers);
+      return true;
+    }
+    return false;
+  }
+
+ private:
+  static constexpr int kSparseFormat = 1;
+  static constexpr int kDenseFormat = 2;
+
+  // Returns the position of the leftmost 1 bit in the bits of 'hash' that
+  // follow the first 'index_bits' bits, counting from 1.
+  static uint8_t rank_of(uint64_t hash, int index_bits) {
+    const uint64_t w = hash << index_bits;
+    return w == 0 ? uint8_t(64 - index_bits + 1)
+                  : uint8_t(__builtin_clzll(w) + 1);
+  }
+
+  // Sparse entries pack the 25-bit index above the 6-bit rank, so that
+  // sorting them groups entries by index with the highest rank last.
+  static uint32_t sparse_entry(uint64_t hash) {
+    return uint32_t(hash >> (64 - kSparsePrecision)) << 6 |
+           rank_of(hash, kSparsePrecision);
+  }
+
+  static double alpha(size_t m) {
+    switch (m) {
+      case 16: return 0.673;
+      case 32: return 0.697;
+      case 64: return 0.709;
+      default: return 0.7213 / (1 + 1.079 / m);
+    }
+  }
+
+  static void append_varint(std::string* out, uint64_t value) {
+    while (value >= 0x80) {
+      out->push_back(char((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    out->push_back(char(value));
+  }
+
+  static bool parse_varint(const unsigned char** p, const unsigned char* end,
+                           uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64 && *p != end; shift += 7) {
+      const unsigned char byte = *(*p)++;
+      *value |= uint64_t{byte & 0x7fu} << shift;
+      if (!(byte & 0x80)) return true;
+    }
+    return false;
+  }
+
+  // The sparse list is converted to registers once it would take more
+  // memory than they do.
+  size_t sparse_limit() const { return (size_t{1} << precision_) / 4; }
+  size_t buffer_limit() const { return sparse_limit() / 4 + 16; }
+
+  // Returns the sorted sparse list, with buffer_ merged in and only the
+  // highest-ranked entry kept for each index.
+  std::vector<uint32_t> merged_sparse_entries() const {
+    std::vector<uint32_t> sorted_buffer(buffer_);
+    std::sort(sorted_buffer.begin(), sorted_buffer.end());
+    std::vector<uint32_t> merged;
+    merged.reserve(sparse_.size() + sorted_buffer.size());
+    std::merge(sparse_.begin(), sparse_.end(), sorted_buffer.begin(),
+               sorted_buffer.end(), std::back_inserter(merged));
+    size_t out = 0;
+    for (size_t i = 0; i < merged.size(); ++i) {
+      if (i + 1 == merged.size() || (merged[i] >> 6) != (merged[i + 1] >> 6)) {
+        merged[out++] = merged[i];
+      }
+    }
+    merged.resize(out);
+    return merged;
+  }
+
+  void flush_buffer() {
+    sparse_ = merged_sparse_entries();
+    buffer_.clear();
+    if (sparse_.size() > sparse_limit()) convert_to_dense();
+  }
+
+  void merge_into_registers(uint32_t entry) {
+    const int extra_bits = kSparsePrecision - precision_;
+    const uint32_t sparse_index = entry >> 6;
+    const uint32_t low_bits = sparse_index & ((uint32_t{1} << extra_bits) - 1);
+    // If the index bits that the dense representation doesn't use contain a
+    // 1, they determine the rank; otherwise it extends the sparse rank.
+    const uint8_t rank =
+        low_bits != 0
+            ? uint8_t(__builtin_clz(low_bits) - (32 - extra_bits) + 1)
+            : uint8_t(extra_bits + (entry & 63));
+    uint8_t& reg = registers_[sparse_index >> extra_bits];
+    reg = std::max(reg, rank);
+  }
+
+  void convert_to_dense() {
+    std::vector<uint32_t> entries = merged_sparse_entries();
+    sparse_.clear();
+    sparse_.shrink_to_fit();
+    buffer_.clear();
+    buffer_.shrink_to_fit();
+    registers_.assign(size_t{1} << precision_, 0);
+    for (uint32_t entry : entries) merge_into_registers(entry);
+  }
+
+  int precision_;
+
+  // Exactly one of these representations is in use: registers_ is
+  // non-empty iff the sketch is dense. In the sparse representation,
+  // sparse_ is sorted and deduplicated, and buffer_ holds recent insertions
+  // that have not yet been merged into it.
+  std::vector<uint32_t> sparse_;
+  std::vector<uint32_t> buffer_;
+  std::vector<uint8_t> registers_;
+
+  Hash hash_;
+};
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_HYPERLOGLOG_H
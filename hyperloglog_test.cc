@@ -0,0 +1,148 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "hyperloglog.h"
+
+namespace {
+
+using Sketch = hashing::hyperloglog<int>;
+
+TEST(HyperLogLogTest, EmptySketch) {
+  Sketch sketch;
+  EXPECT_TRUE(sketch.is_sparse());
+  EXPECT_EQ(0.0, sketch.estimate());
+}
+
+TEST(HyperLogLogTest, SparseIsNearExact) {
+  Sketch sketch;
+  for (int i = 0; i < 1000; ++i) {
+    sketch.insert(i);
+    sketch.insert(i);
+  }
+  EXPECT_TRUE(sketch.is_sparse());
+  EXPECT_NEAR(1000, sketch.estimate(), 1);
+}
+
+TEST(HyperLogLogTest, DenseEstimate) {
+  for (int n : {5000, 20000, 100000, 1000000}) {
+    SCOPED_TRACE(n);
+    Sketch sketch;
+    for (int i = 0; i < n; ++i) {
+      sketch.insert(i);
+    }
+    EXPECT_FALSE(sketch.is_sparse());
+    // The standard error at precision 14 is 1.04 / sqrt(2^14) = 0.8%.
+    EXPECT_NEAR(n, sketch.estimate(), 0.03 * n);
+  }
+}
+
+TEST(HyperLogLogTest, StringKeys) {
+  hashing::hyperloglog<std::string> sketch;
+  for (int i = 0; i < 50000; ++i) {
+    sketch.insert("user" + std::to_string(i % 10000));
+  }
+  EXPECT_NEAR(10000, sketch.estimate(), 300);
+}
+
+TEST(HyperLogLogTest, MergeIsUnion) {
+  for (int n : {100, 1000, 100000}) {
+    SCOPED_TRACE(n);
+    Sketch all, even, odd, mixed;
+    for (int i = 0; i < n; ++i) {
+      all.insert(i);
+      (i % 2 ? odd : even).insert(i);
+    }
+    // Merge a sparse sketch into a dense one, to exercise both paths.
+    for (int i = 0; i < 100000; ++i) {
+      mixed.insert(-i - 1);
+    }
+    Sketch merged = even;
+    merged.merge(odd);
+    EXPECT_EQ(all.serialize(), merged.serialize());
+
+    Sketch merged_into_dense = mixed;
+    merged_into_dense.merge(all);
+    Sketch merged_into_sparse = all;
+    merged_into_sparse.merge(mixed);
+    EXPECT_EQ(merged_into_dense.serialize(), merged_into_sparse.serialize());
+  }
+}
+
+TEST(HyperLogLogTest, SparseToDenseConversionIsConsistent) {
+  // A sketch that went dense after merging small sparse sketches must have
+  // the same registers as one that was built dense directly.
+  Sketch direct, merged;
+  for (int i = 0; i < 100000; ++i) {
+    direct.insert(i);
+  }
+  for (int shard = 0; shard < 100; ++shard) {
+    Sketch part;
+    for (int i = shard; i < 100000; i += 100) {
+      part.insert(i);
+    }
+    merged.merge(part);
+  }
+  EXPECT_EQ(direct.serialize(), merged.serialize());
+}
+
+TEST(HyperLogLogTest, SerializationRoundTrip) {
+  for (int n : {0, 10, 1000, 100000}) {
+    SCOPED_TRACE(n);
+    Sketch sketch(12);
+    for (int i = 0; i < n; ++i) {
+      sketch.insert(i);
+    }
+    const std::string bytes = sketch.serialize();
+    Sketch restored;
+    ASSERT_TRUE(restored.deserialize(bytes));
+    EXPECT_EQ(12, restored.precision());
+    EXPECT_EQ(sketch.is_sparse(), restored.is_sparse());
+    EXPECT_EQ(sketch.estimate(), restored.estimate());
+    EXPECT_EQ(bytes, restored.serialize());
+  }
+}
+
+TEST(HyperLogLogTest, SerializedFormIsCompact) {
+  Sketch sparse, dense;
+  for (int i = 0; i < 100; ++i) {
+    sparse.insert(i);
+  }
+  for (int i = 0; i < 100000; ++i) {
+    dense.insert(i);
+  }
+  EXPECT_LT(sparse.serialize().size(), 4 * 100u);
+  EXPECT_EQ(2 + (1u << 14) * 6 / 8, dense.serialize().size());
+}
+
+TEST(HyperLogLogTest, RejectsMalformedInput) {
+  Sketch sketch;
+  sketch.insert(1);
+  const std::string good = sketch.serialize();
+  EXPECT_FALSE(sketch.deserialize(""));
+  EXPECT_FALSE(sketch.deserialize(good.substr(0, good.size() - 1)));
+  EXPECT_FALSE(sketch.deserialize(good + '\0'));
+  std::string bad_precision = good;
+  bad_precision[1] = 30;
+  EXPECT_FALSE(sketch.deserialize(bad_precision));
+  std::string bad_format = good;
+  bad_format[0] = 7;
+  EXPECT_FALSE(sketch.deserialize(bad_format));
+  EXPECT_EQ(good, sketch.serialize());
+}
+
+}  // namespace
@@ -0,0 +1,283 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Generators of realistic string keys for benchmarks (URLs, UUIDs, short
+// identifiers and JSON-like composite keys), with Zipfian distributions of
+// length and popularity, and loading and saving of corpus files. Not part of
+// this proposal.
+
+#ifndef HASHING_DEMO_KEY_CORPUS_H
+#define HASHING_DEMO_KEY_CORPUS_H
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace hashing {
+
+// Samples integers in [0, n) with P(i) proportional to 1 / (i + 1)^s, so
+// that 0 is the most popular value. s = 1 approximates e.g. word and URL
+// popularity. n must be positive.
+class zipfian_distribution {
+ public:
+  explicit zipfian_distribution(size_t n, double s = 1.0) : cdf_(n) {
+    assert(n > 0);
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+      sum += 1.0 / std::pow(double(i + 1), s);
+      cdf_[i] = sum;
+    }
+    for (double& c : cdf_) c /= sum;
+  }
+
+  template <typename URNG>
+  size_t operator()(URNG& engine) const {
+    const double u = std::uniform_real_distribution<double>()(engine);
+    const size_t i = std::upper_bound(cdf_.begin(), cdf_.end(), u) -
+                     cdf_.begin();
+    return std::min(i, cdf_.size() - 1);
+  }
+
+ private:
+  std::vector<double> cdf_;
+};
+
+// Returns 'count' indices into a corpus of 'n' keys, with Zipfian
+// popularity, for lookup streams where a few keys are very hot. Returns no
+// indices if n is 0.
+inline std::vector<size_t> zipfian_indices(size_t n, size_t count,
+                                           double s = 1.0,
+                                           uint64_t seed = 0) {
+  if (n == 0) return {};
+  std::mt19937_64 engine(seed);
+  const zipfian_distribution dist(n, s);
+  std::vector<size_t> indices(count);
+  for (size_t& i : indices) i = dist(engine);
+  return indices;
+}
+
+enum class key_corpus_kind {
+  // http(s) URLs on a Zipfian set of hosts, with a Zipfian number of path
+  // segments and an optional query string; typically 30-100 bytes.
+  urls,
+  // Random version 4 UUIDs in canonical form, always 36 bytes.
+  uuids,
+  // Short alphanumeric identifiers with Zipfian lengths from 4 to 32
+  // bytes, mostly under 8.
+  identifiers,
+  // Flat JSON objects with a few fields, like serialized composite keys;
+  // typically 50-80 bytes.
+  json,
+};
+
+inline constexpr key_corpus_kind kAllKeyCorpusKinds[] = {
+    key_corpus_kind::urls, key_corpus_kind::uuids,
+    key_corpus_kind::identifiers, key_corpus_kind::json};
+inline constexpr size_t kNumKeyCorpusKinds =
+    sizeof(kAllKeyCorpusKinds) / sizeof(kAllKeyCorpusKinds[0]);
+
+inline const char* key_corpus_name(key_corpus_kind kind) {
+  switch (kind) {
+    case key_corpus_kind::urls: return "urls";
+    case key_corpus_kind::uuids: return "uuids";
+    case key_corpus_kind::identifiers: return "identifiers";
+    case key_corpus_kind::json: return "json";
+  }
+  return "unknown";
+}
+
+namespace detail {
+
+inline std::string random_alnum(std::mt19937_64& engine, size_t length) {
+  static const char kChars[] =
+      "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+  std::uniform_int_distribution<size_t> dist(0, sizeof(kChars) - 2);
+  std::string result(length, ' ');
+  for (char& c : result) c = kChars[dist(engine)];
+  return result;
+}
+
+inline std::string random_url(std::mt19937_64& engine,
+                              const zipfian_distribution& hosts,
+                              const zipfian_distribution& segments) {
+  static const char* const kTlds[] = {".com", ".org", ".net", ".io",
+                                      ".co.uk", ".de"};
+  const size_t host = hosts(engine);
+  std::string url = (host % 4 == 0) ? "http://" : "https://";
+  url += (host % 3 == 0) ? "www." : "";
+  url += "site" + std::to_string(host) + kTlds[host % 6];
+  const size_t num_segments = 1 + segments(engine);
+  std::uniform_int_distribution<size_t> segment_length(3, 12);
+  for (size_t i = 0; i < num_segments; ++i) {
+    url += "/" + random_alnum(engine, segment_length(engine));
+  }
+  if (engine() % 3 == 0) {
+    url += "?id=" + std::to_string(engine() % 1000000);
+  }
+  return url;
+}
+
+inline std::string random_uuid(std::mt19937_64& engine) {
+  static const char kHex[] = "0123456789abcdef";
+  std::string uuid = "xxxxxxxx-xxxx-4xxx-yxxx-xxxxxxxxxxxx";
+  for (char& c : uuid) {
+    if (c == 'x') {
+      c = kHex[engine() % 16];
+    } else if (c == 'y') {
+      c = kHex[8 + engine() % 4];
+    }
+  }
+  return uuid;
+}
+
+inline std::string random_json(std::mt19937_64& engine,
+                               const zipfian_distribution& users) {
+  static const char* const kRegions[] = {"us-east", "us-west", "eu-west",
+                                         "ap-south"};
+  std::string json = "{\"user\":" + std::to_string(users(engine)) +
+                     ",\"region\":\"" + kRegions[engine() % 4] +
+                     "\",\"session\":\"" + random_alnum(engine, 8) + "\"";
+  if (engine() % 2 == 0) {
+    json += ",\"shard\":" + std::to_string(engine() % 64);
+  }
+  return json + "}";
+}
+
+// Removes all but the first occurrence of each key, keeping their order.
+inline void remove_duplicate_keys(std::vector<std::string>* keys) {
+  std::unordered_set<std::string> seen;
+  keys->erase(std::remove_if(keys->begin(), keys->end(),
+                             [&seen](const std::string& key) {
+                               return !seen.insert(key).second;
+                             }),
+              keys->end());
+}
+
+}  // namespace detail
+
+// Returns 'n' keys of the given kind, generated deterministically from
+// 'seed'. Keys may repeat, as they would in real data; URLs and JSON keys
+// have Zipfian popularity components (hosts and users).
+inline std::vector<std::string> generate_key_corpus(key_corpus_kind kind,
+                                                    size_t n,
+                                                    uint64_t seed = 0) {
+  std::mt19937_64 engine(seed);
+  std::vector<std::string> keys;
+  keys.reserve(n);
+  switch (kind) {
+    case key_corpus_kind::urls: {
+      const zipfian_distribution hosts(1000), segments(6);
+      for (size_t i = 0; i < n; ++i) {
+        keys.push_back(detail::random_url(engine, hosts, segments));
+      }
+      break;
+    }
+    case key_corpus_kind::uuids:
+      for (size_t i = 0; i < n; ++i) {
+        keys.push_back(detail::random_uuid(engine));
+      }
+      break;
+    case key_corpus_kind::identifiers: {
+      const zipfian_distribution lengths(29);
+      for (size_t i = 0; i < n; ++i) {
+        keys.push_back(detail::random_alnum(engine, 4 + lengths(engine)));
+      }
+      break;
+    }
+    case key_corpus_kind::json: {
+      const zipfian_distribution users(100000);
+      for (size_t i = 0; i < n; ++i) {
+        keys.push_back(detail::random_json(engine, users));
+      }
+      break;
+    }
+  }
+  return keys;
+}
+
+// Like generate_key_corpus(), but without duplicates, for building tables.
+// May return fewer than 'n' keys if the kind can't produce that many
+// distinct ones.
+inline std::vector<std::string> generate_distinct_keys(key_corpus_kind kind,
+                                                       size_t n,
+                                                       uint64_t seed = 0) {
+  std::vector<std::string> keys = generate_key_corpus(kind, n, seed);
+  detail::remove_duplicate_keys(&keys);
+  return keys;
+}
+
+// Reads a corpus file with one key per line, appending the keys to 'keys'.
+// Returns false if the file can't be read.
+inline bool load_key_corpus(const std::string& path,
+                            std::vector<std::string>* keys) {
+  std::ifstream in(path);
+  if (!in) return false;
+  std::string line;
+  while (std::getline(in, line)) keys->push_back(line);
+  return !in.bad();
+}
+
+// Writes 'keys' to a corpus file readable by load_key_corpus(). Keys must
+// not contain newlines. Returns false on error.
+inline bool save_key_corpus(const std::string& path,
+                            const std::vector<std::string>& keys) {
+  std::ofstream out(path);
+  for (const std::string& key : keys) out << key << '\n';
+  return bool(out);
+}
+
+// Returns the keys for benchmark corpus 'index': the first
+// kNumKeyCorpusKinds are generated, as generate_distinct_keys() if
+// 'distinct' is true and otherwise as generate_key_corpus(), and the next
+// is read from the file named by the HASHING_DEMO_KEY_CORPUS environment
+// variable, if any. At most 'n' keys are returned; the result is empty if
+// the corpus file isn't set or can't be read.
+inline std::vector<std::string> benchmark_key_corpus(size_t index, size_t n,
+                                                     bool distinct = false) {
+  if (index < kNumKeyCorpusKinds) {
+    return distinct ? generate_distinct_keys(kAllKeyCorpusKinds[index], n)
+                    : generate_key_corpus(kAllKeyCorpusKinds[index], n);
+  }
+  std::vector<std::string> keys;
+  const char* path = std::getenv("HASHING_DEMO_KEY_CORPUS");
+  if (path == nullptr || !load_key_corpus(path, &keys)) return {};
+  if (distinct) detail::remove_duplicate_keys(&keys);
+  if (keys.size() > n) keys.resize(n);
+  return keys;
+}
+
+inline const char* benchmark_key_corpus_name(size_t index) {
+  return index < kNumKeyCorpusKinds
+             ? key_corpus_name(kAllKeyCorpusKinds[index])
+             : "file";
+}
+
+// Returns the number of benchmark corpora: the generated ones, plus the
+// HASHING_DEMO_KEY_CORPUS file if that variable is set.
+inline size_t num_benchmark_key_corpora() {
+  return kNumKeyCorpusKinds +
+         (std::getenv("HASHING_DEMO_KEY_CORPUS") != nullptr ? 1 : 0);
+}
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_KEY_CORPUS_H
@@ -0,0 +1,131 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "key_corpus.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+using ::hashing::generate_distinct_keys;
+using ::hashing::generate_key_corpus;
+using ::hashing::key_corpus_kind;
+
+TEST(KeyCorpusTest, IsDeterministic) {
+  for (key_corpus_kind kind : hashing::kAllKeyCorpusKinds) {
+    EXPECT_EQ(generate_key_corpus(kind, 100, 7),
+              generate_key_corpus(kind, 100, 7))
+        << hashing::key_corpus_name(kind);
+    EXPECT_NE(generate_key_corpus(kind, 100, 7),
+              generate_key_corpus(kind, 100, 8))
+        << hashing::key_corpus_name(kind);
+  }
+}
+
+TEST(KeyCorpusTest, Urls) {
+  for (const std::string& url :
+       generate_key_corpus(key_corpus_kind::urls, 1000)) {
+    EXPECT_TRUE(url.compare(0, 7, "http://") == 0 ||
+                url.compare(0, 8, "https://") == 0)
+        << url;
+  }
+}
+
+TEST(KeyCorpusTest, Uuids) {
+  for (const std::string& uuid :
+       generate_key_corpus(key_corpus_kind::uuids, 1000)) {
+    ASSERT_EQ(36u, uuid.size());
+    EXPECT_EQ('-', uuid[8]);
+    EXPECT_EQ('-', uuid[13]);
+    EXPECT_EQ('4', uuid[14]);
+    EXPECT_EQ('-', uuid[18]);
+    EXPECT_NE(std::string::npos, std::string("89ab").find(uuid[19]));
+    EXPECT_EQ('-', uuid[23]);
+  }
+}
+
+TEST(KeyCorpusTest, IdentifierLengthsAreZipfian) {
+  size_t short_ids = 0;
+  const auto ids = generate_key_corpus(key_corpus_kind::identifiers, 10000);
+  for (const std::string& id : ids) {
+    EXPECT_GE(id.size(), 4u);
+    EXPECT_LE(id.size(), 32u);
+    short_ids += id.size() < 8;
+  }
+  EXPECT_GT(short_ids, ids.size() / 2);
+}
+
+TEST(KeyCorpusTest, Json) {
+  for (const std::string& json :
+       generate_key_corpus(key_corpus_kind::json, 1000)) {
+    EXPECT_EQ(0u, json.find("{\"user\":"));
+    EXPECT_EQ('}', json.back());
+  }
+}
+
+TEST(KeyCorpusTest, DistinctKeys) {
+  for (key_corpus_kind kind : hashing::kAllKeyCorpusKinds) {
+    const auto keys = generate_distinct_keys(kind, 10000);
+    EXPECT_GT(keys.size(), 9000u) << hashing::key_corpus_name(kind);
+    EXPECT_EQ(keys.size(),
+              std::unordered_set<std::string>(keys.begin(), keys.end())
+                  .size());
+  }
+}
+
+TEST(KeyCorpusTest, ZipfianPopularity) {
+  const auto indices = hashing::zipfian_indices(1000, 100000);
+  std::vector<size_t> counts(1000);
+  for (size_t i : indices) {
+    ASSERT_LT(i, 1000u);
+    ++counts[i];
+  }
+  // P(0) = 1 / H(1000), about 0.134, and P(0) / P(1) = 2.
+  EXPECT_NEAR(0.134, counts[0] / 100000.0, 0.01);
+  EXPECT_NEAR(2.0, double(counts[0]) / counts[1], 0.2);
+}
+
+TEST(KeyCorpusTest, ZipfianIndicesIntoEmptyCorpus) {
+  EXPECT_TRUE(hashing::zipfian_indices(0, 100).empty());
+}
+
+TEST(KeyCorpusTest, FileCorpusCountsOnlyWhenSet) {
+  unsetenv("HASHING_DEMO_KEY_CORPUS");
+  EXPECT_EQ(hashing::kNumKeyCorpusKinds, hashing::num_benchmark_key_corpora());
+  setenv("HASHING_DEMO_KEY_CORPUS", "/nonexistent", 1);
+  EXPECT_EQ(hashing::kNumKeyCorpusKinds + 1,
+            hashing::num_benchmark_key_corpora());
+  unsetenv("HASHING_DEMO_KEY_CORPUS");
+}
+
+TEST(KeyCorpusTest, SaveAndLoad) {
+  const std::string path =
+      ::testing::TempDir() + "/key_corpus_test_corpus.txt";
+  const auto keys = generate_key_corpus(key_corpus_kind::urls, 100);
+  ASSERT_TRUE(hashing::save_key_corpus(path, keys));
+  std::vector<std::string> loaded;
+  ASSERT_TRUE(hashing::load_key_corpus(path, &loaded));
+  EXPECT_EQ(keys, loaded);
+  std::remove(path.c_str());
+
+  EXPECT_FALSE(hashing::load_key_corpus(path, &loaded));
+}
+
+}  // namespace
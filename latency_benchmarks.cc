@@ -0,0 +1,303 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Per-call latency distributions of hashing and of hash table lookups.
+// google/benchmark times batches of calls, so it can only report their
+// mean; this times every call individually, with the timestamp counter on
+// x86 and steady_clock elsewhere, less the cost of reading the clock, and
+// reports percentiles, and optionally histograms, in nanoseconds for each
+// hasher and string length.
+//
+// Usage:
+//   latency_benchmarks [--samples=N] [--histogram] [--filter=SUBSTRING]
+//
+// --filter selects the rows whose name contains SUBSTRING.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HASHING_DEMO_HAVE_RDTSC 1
+#else
+#define HASHING_DEMO_HAVE_RDTSC 0
+#endif
+
+#include "benchmark/benchmark.h"
+
+#include "farmhash-direct.h"
+#include "fnv1a.h"
+#include "hash_util.h"
+#include "n3980-farmhash.h"
+#include "n3980.h"
+#include "std.h"
+
+namespace {
+
+// Returns the time at the start of a timed region, in clock ticks. The
+// fences keep the timed code from starting before the counter is read,
+// and the preceding code from finishing after it.
+inline uint64_t StartTicks() {
+#if HASHING_DEMO_HAVE_RDTSC
+  _mm_lfence();
+  const uint64_t ticks = __rdtsc();
+  _mm_lfence();
+  return ticks;
+#else
+  return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+// Returns the time at the end of a timed region. rdtscp waits for the
+// timed code to finish, and the fence keeps later code from starting
+// before the counter is read.
+inline uint64_t StopTicks() {
+#if HASHING_DEMO_HAVE_RDTSC
+  unsigned int aux;
+  const uint64_t ticks = __rdtscp(&aux);
+  _mm_lfence();
+  return ticks;
+#else
+  return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+struct Clock {
+  double ns_per_tick;
+  // The ticks measured for an empty timed region, which are subtracted
+  // from every measurement.
+  uint64_t overhead_ticks;
+};
+
+Clock Calibrate() {
+  Clock clock;
+  // The timestamp counter runs at a constant rate on any x86 processor
+  // recent enough to have rdtscp, so it only needs to be compared with
+  // steady_clock once.
+  const auto wall_start = std::chrono::steady_clock::now();
+  const uint64_t start = StartTicks();
+  while (std::chrono::steady_clock::now() - wall_start <
+         std::chrono::milliseconds(100)) {
+  }
+  const uint64_t stop = StopTicks();
+  const auto wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - wall_start);
+  clock.ns_per_tick = double(wall_ns.count()) / (stop - start);
+
+  // The minimum rather than, say, the median, so that the fastest calls
+  // aren't all rounded down to zero.
+  clock.overhead_ticks = UINT64_MAX;
+  for (int i = 0; i < 100000; ++i) {
+    const uint64_t start = StartTicks();
+    const uint64_t stop = StopTicks();
+    clock.overhead_ticks = std::min(clock.overhead_ticks, stop - start);
+  }
+  return clock;
+}
+
+struct Options {
+  size_t samples = 100000;
+  bool histogram = false;
+  std::string filter;
+};
+
+// Latencies of individual calls, in nanoseconds.
+class LatencyDistribution {
+ public:
+  explicit LatencyDistribution(std::vector<double> ns)
+      : ns_(std::move(ns)) {
+    std::sort(ns_.begin(), ns_.end());
+  }
+
+  // Returns the smallest latency that at least fraction 'p' of the calls
+  // didn't exceed.
+  double percentile(double p) const {
+    if (ns_.empty()) return 0;
+    const size_t rank = static_cast<size_t>(p * ns_.size());
+    return ns_[std::min(rank, ns_.size() - 1)];
+  }
+
+  double mean() const {
+    double sum = 0;
+    for (double ns : ns_) sum += ns;
+    return ns_.empty() ? 0 : sum / ns_.size();
+  }
+
+  // Prints the number of calls in each power-of-two range of latencies,
+  // starting with [0, 1) ns.
+  void PrintHistogram() const {
+    std::vector<size_t> counts;
+    for (double ns : ns_) {
+      size_t bucket = 0;
+      while (ns >= 1 && bucket < 40) {
+        ns /= 2;
+        ++bucket;
+      }
+      if (counts.size() <= bucket) counts.resize(bucket + 1);
+      ++counts[bucket];
+    }
+    const size_t max_count =
+        counts.empty() ? 0 : *std::max_element(counts.begin(), counts.end());
+    for (size_t bucket = 0; bucket < counts.size(); ++bucket) {
+      if (counts[bucket] == 0) continue;
+      const double low = bucket == 0 ? 0 : double(uint64_t(1) << (bucket - 1));
+      const double high = double(uint64_t(1) << bucket);
+      std::printf("  [%8.0f, %8.0f) ns %9zu %s\n", low, high, counts[bucket],
+                  std::string(50 * counts[bucket] / max_count, '#').c_str());
+    }
+  }
+
+ private:
+  std::vector<double> ns_;
+};
+
+void PrintHeader() {
+  std::printf("%-50s %9s %9s %9s %9s %9s %9s %9s\n", "Latency (ns)", "min",
+              "mean", "p50", "p90", "p99", "p999", "max");
+  std::printf("%s\n", std::string(50 + 7 * 10, '-').c_str());
+}
+
+// Times 'samples' calls of f(i), with i from 0 to samples - 1, after
+// warming up the caches and branch predictors with the same calls, and
+// prints the distribution as a row named 'name'.
+template <typename F>
+void Measure(const Clock& clock, const Options& options,
+             const std::string& name, F f) {
+  if (name.find(options.filter) == std::string::npos) return;
+  for (size_t i = 0; i < std::min<size_t>(options.samples, 10000); ++i) {
+    f(i);
+  }
+  std::vector<double> ns(options.samples);
+  for (size_t i = 0; i < options.samples; ++i) {
+    const uint64_t start = StartTicks();
+    f(i);
+    const uint64_t stop = StopTicks();
+    const uint64_t ticks = stop - start;
+    ns[i] = (ticks > clock.overhead_ticks ? ticks - clock.overhead_ticks : 0) *
+            clock.ns_per_tick;
+  }
+  const LatencyDistribution latency(std::move(ns));
+  std::printf("%-50s %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n",
+              name.c_str(), latency.percentile(0), latency.mean(),
+              latency.percentile(0.5), latency.percentile(0.9),
+              latency.percentile(0.99), latency.percentile(0.999),
+              latency.percentile(1));
+  if (options.histogram) latency.PrintHistogram();
+}
+
+// Returns 'count' distinct random strings of length 'length'.
+std::vector<std::string> MakeStrings(size_t length, size_t count) {
+  std::mt19937_64 engine(length);
+  std::unordered_set<std::string> seen;
+  std::vector<std::string> strings;
+  strings.reserve(count);
+  while (strings.size() < count) {
+    std::string s(length, ' ');
+    for (char& c : s) c = static_cast<char>(engine());
+    if (seen.insert(s).second) strings.push_back(std::move(s));
+  }
+  return strings;
+}
+
+// farmhash on the string's bytes alone, without its size.
+struct farmhash_direct_hasher {
+  size_t operator()(const std::string& s) const {
+    return hashing::direct::farmhash::Hash64(s.data(), s.size());
+  }
+};
+
+// Each hasher is timed on strings from a pool much larger than one, so
+// that consecutive calls don't hash the same bytes, but small enough to
+// stay in cache; lookups search a table of kTableSize strings of the same
+// length, in random order.
+constexpr size_t kPoolSize = 4096;
+constexpr size_t kTableSize = 1 << 16;
+
+template <typename Hash>
+void MeasureHasher(const Clock& clock, const Options& options,
+                   const std::string& hasher_name) {
+  // farmhash finalizes inputs of up to 64 bytes with its short-input
+  // paths, and longer ones with final_mix(). farmhash_direct_hasher makes
+  // that transition between 64 and 65 bytes, but hash_value() also hashes
+  // a string's size, so the HashCode-based hashers make it between 56 and
+  // 57.
+  for (size_t length : {8, 16, 32, 48, 56, 57, 64, 65, 128, 1024}) {
+    const std::string suffix = "/" + std::to_string(length);
+    const std::vector<std::string> pool = MakeStrings(length, kPoolSize);
+    const Hash hash;
+    Measure(clock, options, "hash/" + hasher_name + suffix, [&](size_t i) {
+      benchmark::DoNotOptimize(hash(pool[i % kPoolSize]));
+    });
+
+    const std::string lookup_name = "find/" + hasher_name + suffix;
+    if (lookup_name.find(options.filter) == std::string::npos) continue;
+    const std::vector<std::string> keys = MakeStrings(length, kTableSize);
+    const std::unordered_set<std::string, Hash> table(keys.begin(),
+                                                      keys.end());
+    std::vector<size_t> order(kTableSize);
+    std::mt19937_64 engine;
+    for (size_t& i : order) i = engine() % kTableSize;
+    Measure(clock, options, lookup_name, [&](size_t i) {
+      benchmark::DoNotOptimize(table.find(keys[order[i % kTableSize]]));
+    });
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    if (std::strncmp(arg, "--samples=", 10) == 0) {
+      options.samples = std::strtoull(arg + 10, nullptr, 10);
+    } else if (std::strcmp(arg, "--histogram") == 0) {
+      options.histogram = true;
+    } else if (std::strncmp(arg, "--filter=", 9) == 0) {
+      options.filter = arg + 9;
+    } else {
+      std::fprintf(stderr,
+                   "Usage: %s [--samples=N] [--histogram] "
+                   "[--filter=SUBSTRING]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+  if (options.samples == 0) options.samples = 1;
+
+  const Clock clock = Calibrate();
+  std::printf("Clock: %s, %.3f ns/tick, overhead %llu ticks subtracted\n\n",
+              HASHING_DEMO_HAVE_RDTSC ? "rdtsc" : "steady_clock",
+              clock.ns_per_tick,
+              static_cast<unsigned long long>(clock.overhead_ticks));
+  PrintHeader();
+  MeasureHasher<std::hash<std::string>>(clock, options, "std::hash");
+  MeasureHasher<std_::hash<std::string>>(clock, options, "std_::hash");
+  MeasureHasher<farmhash_direct_hasher>(clock, options, "farmhash_direct");
+  MeasureHasher<hashing::hash_code_hasher<hashing::fnv1a, std::string>>(
+      clock, options, "fnv1a");
+  MeasureHasher<std_::uhash<hashing::n3980::farmhash>>(
+      clock, options, "uhash<n3980::farmhash>");
+  return 0;
+}
@@ -0,0 +1,384 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Minimal perfect hash function for large static key sets, for any type
+// that std_::hash supports. Not part of this proposal.
+
+#ifndef HASHING_DEMO_MINIMAL_PERFECT_HASH_H
+#define HASHING_DEMO_MINIMAL_PERFECT_HASH_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "std.h"
+
+namespace hashing {
+
+// Maps each of a fixed set of n distinct keys to a distinct index in
+// [0, n), using about 3.8 bits per key with the default gamma of 2, without
+// storing the keys. Looking up a key that is not in the set returns an
+// arbitrary index, or n; callers that need to reject such keys must check
+// the key stored at the returned index.
+//
+// This follows BBHash (Limasset et al., "Fast and scalable minimal perfect
+// hashing for massive key sets"). Keys are placed in a cascade of bit
+// arrays: at each level, every remaining key hashes to one bit, and the keys
+// that don't collide with another key set their bit and are done. The
+// colliding keys move on to the next, smaller level. A key's index is the
+// number of set bits before its bit, across all levels.
+//
+// Each key is hashed once with Hash; the hash for each level is derived from
+// that value with a cheap mix. The bit arrays are stored in 64-byte blocks
+// of one rank word followed by 448 bits, so that a lookup that ends at the
+// first level, as most do, touches a single cache line.
+template <typename T, typename Hash = std_::hash<T>>
+class minimal_perfect_hash {
+ public:
+  static constexpr int kMaxLevels = 32;
+
+  explicit minimal_perfect_hash(Hash hash = Hash()) : hash_(std::move(hash)) {}
+
+  // Builds the function for the keys in [begin, end), replacing any
+  // previous contents. 'gamma' (at least 1) trades space for build and
+  // lookup speed: each level has gamma bits per remaining key. The work of
+  // each level is split among up to 'num_threads' threads. Returns false if
+  // two keys have the same 64-bit hash, which includes the case of
+  // duplicate keys.
+  template <typename InputIterator>
+  bool build(InputIterator begin, InputIterator end, double gamma = 2.0,
+             unsigned num_threads = std::thread::hardware_concurrency()) {
+    std::vector<uint64_t> hashes;
+    for (; begin != end; ++begin) {
+      hashes.push_back(static_cast<uint64_t>(hash_(*begin)));
+    }
+    return build_from_hashes(std::move(hashes), gamma, num_threads);
+  }
+
+  // Variant of build() that takes precomputed key hashes.
+  bool build_from_hashes(std::vector<uint64_t> hashes, double gamma = 2.0,
+                         unsigned num_threads =
+                             std::thread::hardware_concurrency()) {
+    assert(gamma >= 1.0);
+    clear();
+    num_keys_ = hashes.size();
+    num_threads = std::max(1u, num_threads);
+    size_t rank = 0;
+    for (int level = 0; level < kMaxLevels && !hashes.empty(); ++level) {
+      const size_t num_blocks = std::max<size_t>(
+          1, size_t(std::ceil(gamma * hashes.size() / kBitsPerBlock)));
+      level_offsets_.push_back(blocks_.size());
+      level_sizes_.push_back(num_blocks);
+      build_level(level, num_threads, &hashes);
+      for (size_t b = level_offsets_.back(); b < blocks_.size(); ++b) {
+        blocks_[b].words[0] = rank;
+        for (int w = 1; w < 8; ++w) {
+          rank += __builtin_popcountll(blocks_[b].words[w]);
+        }
+      }
+    }
+    // Keys left after the last level get the remaining indices, in order of
+    // hash. Two equal hashes can't be told apart by any level.
+    std::sort(hashes.begin(), hashes.end());
+    if (std::adjacent_find(hashes.begin(), hashes.end()) != hashes.end()) {
+      clear();
+      return false;
+    }
+    for (uint64_t hash : hashes) {
+      fallback_.emplace_back(hash, rank++);
+    }
+    assert(rank == num_keys_);
+    return true;
+  }
+
+  // Returns the index of 'key', in [0, size()) if 'key' was in the set the
+  // function was built from.
+  size_t operator()(const T& key) const {
+    return lookup_hash(static_cast<uint64_t>(hash_(key)));
+  }
+
+  // Variant of operator() that takes a precomputed key hash.
+  size_t lookup_hash(uint64_t hash) const {
+    for (size_t level = 0; level < level_offsets_.size(); ++level) {
+      const size_t pos = position(hash, level, level_sizes_[level]);
+      const block& blk = blocks_[level_offsets_[level] + pos / kBitsPerBlock];
+      const size_t bit = pos % kBitsPerBlock;
+      const int word = 1 + int(bit / 64);
+      const uint64_t mask = uint64_t{1} << (bit % 64);
+      if (blk.words[word] & mask) {
+        size_t index = blk.words[0];
+        for (int w = 1; w < word; ++w) {
+          index += __builtin_popcountll(blk.words[w]);
+        }
+        return index + __builtin_popcountll(blk.words[word] & (mask - 1));
+      }
+    }
+    auto it = std::lower_bound(
+        fallback_.begin(), fallback_.end(), std::make_pair(hash, size_t{0}));
+    return it != fallback_.end() && it->first == hash ? it->second
+                                                      : num_keys_;
+  }
+
+  // Returns the number of keys the function was built from.
+  size_t size() const { return num_keys_; }
+  int num_levels() const { return int(level_offsets_.size()); }
+
+  size_t size_in_bits() const {
+    return 8 * (blocks_.size() * sizeof(block) +
+                fallback_.size() * sizeof(fallback_[0]) +
+                level_offsets_.size() * 2 * sizeof(size_t));
+  }
+
+  void clear() {
+    num_keys_ = 0;
+    blocks_.clear();
+    level_offsets_.clear();
+    level_sizes_.clear();
+    fallback_.clear();
+  }
+
+  // Returns a compact serialized form of the function: a format byte, the
+  // key count and per-level block counts as base-128 varints, the bit
+  // arrays as little-endian 64-bit words (rank words excluded, since they
+  // can be recomputed), and the fallback hashes, whose indices are implied
+  // by their order.
+  std::string serialize() const {
+    std::string out;
+    out.push_back(char(kFormat));
+    append_varint(&out, num_keys_);
+    append_varint(&out, level_sizes_.size());
+    for (size_t num_blocks : level_sizes_) append_varint(&out, num_blocks);
+    for (const block& blk : blocks_) {
+      for (int w = 1; w < 8; ++w) append_fixed64(&out, blk.words[w]);
+    }
+    append_varint(&out, fallback_.size());
+    for (const auto& entry : fallback_) append_fixed64(&out, entry.first);
+    return out;
+  }
+
+  // Replaces the contents of this function with the function serialized in
+  // 'bytes' by serialize(). Returns false, leaving the function empty, if
+  // 'bytes' is not a valid serialized function.
+  bool deserialize(const std::string& bytes) {
+    clear();
+    if (!parse(bytes)) {
+      clear();
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  static constexpr int kFormat = 1;
+  static constexpr size_t kBitsPerBlock = 7 * 64;
+
+  struct alignas(64) block {
+    // words[0] is the number of set bits in all previous blocks, and
+    // words[1..7] are the bits.
+    uint64_t words[8];
+  };
+
+  // The MurmurHash3 64-bit finalizer, applied to the key hash offset by a
+  // per-level constant, gives each level an independent hash of the key.
+  static uint64_t level_hash(uint64_t hash, size_t level) {
+    uint64_t h = hash + (level + 1) * 0x9e3779b97f4a7c15ULL;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  // Maps the level hash onto [0, num_blocks * kBitsPerBlock) with a
+  // multiply and shift instead of a division.
+  static size_t position(uint64_t hash, size_t level, size_t num_blocks) {
+    return size_t((static_cast<unsigned __int128>(level_hash(hash, level)) *
+                   (num_blocks * kBitsPerBlock)) >> 64);
+  }
+
+  // Appends the blocks for 'level' and replaces 'hashes' with the hashes
+  // that collided in it.
+  void build_level(size_t level, unsigned num_threads,
+                   std::vector<uint64_t>* hashes) {
+    const size_t num_blocks = level_sizes_[level];
+    const size_t num_words = num_blocks * 8;
+    std::vector<std::atomic<uint64_t>> seen(num_words);
+    std::vector<std::atomic<uint64_t>> collided(num_words);
+    for (size_t i = 0; i < num_words; ++i) {
+      seen[i].store(0, std::memory_order_relaxed);
+      collided[i].store(0, std::memory_order_relaxed);
+    }
+    auto word_and_mask = [&](uint64_t hash) {
+      const size_t pos = position(hash, level, num_blocks);
+      const size_t bit = pos % kBitsPerBlock;
+      return std::make_pair((pos / kBitsPerBlock) * 8 + 1 + bit / 64,
+                            uint64_t{1} << (bit % 64));
+    };
+
+    num_threads = unsigned(std::max<size_t>(
+        1, std::min<size_t>(num_threads, hashes->size() / 4096)));
+    auto for_each_slice = [&](auto&& body) {
+      std::vector<std::thread> threads;
+      for (unsigned thread = 1; thread < num_threads; ++thread) {
+        threads.emplace_back(body, thread);
+      }
+      body(0);
+      for (std::thread& thread : threads) thread.join();
+    };
+    auto slice = [&](unsigned thread) {
+      return std::make_pair(hashes->size() * thread / num_threads,
+                            hashes->size() * (thread + 1) / num_threads);
+    };
+
+    // First pass: set each key's bit, and note the bits set more than once.
+    for_each_slice([&](unsigned thread) {
+      const auto range = slice(thread);
+      for (size_t i = range.first; i < range.second; ++i) {
+        const auto wm = word_and_mask((*hashes)[i]);
+        const uint64_t old =
+            seen[wm.first].fetch_or(wm.second, std::memory_order_relaxed);
+        if (old & wm.second) {
+          collided[wm.first].fetch_or(wm.second, std::memory_order_relaxed);
+        }
+      }
+    });
+    // Second pass: collect the keys whose bits collided.
+    std::vector<std::vector<uint64_t>> remaining(num_threads);
+    for_each_slice([&](unsigned thread) {
+      const auto range = slice(thread);
+      for (size_t i = range.first; i < range.second; ++i) {
+        const auto wm = word_and_mask((*hashes)[i]);
+        if (collided[wm.first].load(std::memory_order_relaxed) & wm.second) {
+          remaining[thread].push_back((*hashes)[i]);
+        }
+      }
+    });
+
+    const size_t first_block = blocks_.size();
+    blocks_.resize(first_block + num_blocks);
+    for (size_t b = 0; b < num_blocks; ++b) {
+      for (int w = 1; w < 8; ++w) {
+        const size_t i = b * 8 + w;
+        blocks_[first_block + b].words[w] =
+            seen[i].load(std::memory_order_relaxed) &
+            ~collided[i].load(std::memory_order_relaxed);
+      }
+    }
+    hashes->clear();
+    for (const std::vector<uint64_t>& r : remaining) {
+      hashes->insert(hashes->end(), r.begin(), r.end());
+    }
+  }
+
+  bool parse(const std::string& bytes) {
+    const unsigned char* p =
+        reinterpret_cast<const unsigned char*>(bytes.data());
+    const unsigned char* end = p + bytes.size();
+    uint64_t num_keys, num_levels;
+    if (p == end || *p++ != kFormat) return false;
+    if (!parse_varint(&p, end, &num_keys) ||
+        !parse_varint(&p, end, &num_levels) || num_levels > kMaxLevels) {
+      return false;
+    }
+    size_t total_blocks = 0;
+    for (uint64_t level = 0; level < num_levels; ++level) {
+      uint64_t num_blocks;
+      if (!parse_varint(&p, end, &num_blocks) || num_blocks == 0 ||
+          num_blocks > size_t(end - p) / (7 * 8)) {
+        return false;
+      }
+      level_offsets_.push_back(total_blocks);
+      level_sizes_.push_back(num_blocks);
+      total_blocks += num_blocks;
+    }
+    if (total_blocks > size_t(end - p) / (7 * 8)) return false;
+    blocks_.resize(total_blocks);
+    size_t rank = 0;
+    for (block& blk : blocks_) {
+      blk.words[0] = rank;
+      for (int w = 1; w < 8; ++w) {
+        blk.words[w] = parse_fixed64(&p);
+        rank += __builtin_popcountll(blk.words[w]);
+      }
+    }
+    uint64_t num_fallback;
+    if (!parse_varint(&p, end, &num_fallback) ||
+        num_fallback != size_t(end - p) / 8 || size_t(end - p) % 8 != 0 ||
+        rank + num_fallback != num_keys) {
+      return false;
+    }
+    for (uint64_t i = 0; i < num_fallback; ++i) {
+      const uint64_t hash = parse_fixed64(&p);
+      if (!fallback_.empty() && fallback_.back().first >= hash) return false;
+      fallback_.emplace_back(hash, rank++);
+    }
+    num_keys_ = num_keys;
+    return true;
+  }
+
+  static void append_varint(std::string* out, uint64_t value) {
+    while (value >= 0x80) {
+      out->push_back(char((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    out->push_back(char(value));
+  }
+
+  static bool parse_varint(const unsigned char** p, const unsigned char* end,
+                           uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64 && *p != end; shift += 7) {
+      const unsigned char byte = *(*p)++;
+      *value |= uint64_t{byte & 0x7fu} << shift;
+      if (!(byte & 0x80)) return true;
+    }
+    return false;
+  }
+
+  static void append_fixed64(std::string* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+      out->push_back(char(value >> (8 * i)));
+    }
+  }
+
+  // Requires: at least 8 bytes remain at *p.
+  static uint64_t parse_fixed64(const unsigned char** p) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+      value |= uint64_t{*(*p)++} << (8 * i);
+    }
+    return value;
+  }
+
+  size_t num_keys_ = 0;
+  std::vector<block> blocks_;
+  // The first block and number of blocks of each level.
+  std::vector<size_t> level_offsets_;
+  std::vector<size_t> level_sizes_;
+  // (hash, index) for the keys placed after the last level, sorted by hash.
+  std::vector<std::pair<uint64_t, size_t>> fallback_;
+  Hash hash_;
+};
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_MINIMAL_PERFECT_HASH_H
@@ -0,0 +1,107 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "minimal_perfect_hash.h"
+
+namespace {
+
+std::vector<std::string> Keys(int n) {
+  std::vector<std::string> keys;
+  for (int i = 0; i < n; ++i) {
+    keys.push_back("key" + std::to_string(i));
+  }
+  return keys;
+}
+
+// Expects 'mphf' to map 'keys' one-to-one onto [0, keys.size()).
+void ExpectMinimalPerfect(
+    const hashing::minimal_perfect_hash<std::string>& mphf,
+    const std::vector<std::string>& keys) {
+  ASSERT_EQ(keys.size(), mphf.size());
+  std::vector<bool> used(keys.size());
+  for (const std::string& key : keys) {
+    const size_t index = mphf(key);
+    ASSERT_LT(index, keys.size()) << key;
+    EXPECT_FALSE(used[index]) << key;
+    used[index] = true;
+  }
+}
+
+TEST(MinimalPerfectHashTest, IsMinimalAndPerfect) {
+  const std::vector<std::string> keys = Keys(100000);
+  for (double gamma : {1.0, 2.0, 5.0}) {
+    hashing::minimal_perfect_hash<std::string> mphf;
+    ASSERT_TRUE(mphf.build(keys.begin(), keys.end(), gamma));
+    ExpectMinimalPerfect(mphf, keys);
+  }
+}
+
+TEST(MinimalPerfectHashTest, SpaceIsCompact) {
+  const std::vector<std::string> keys = Keys(100000);
+  hashing::minimal_perfect_hash<std::string> mphf;
+  ASSERT_TRUE(mphf.build(keys.begin(), keys.end()));
+  EXPECT_LT(mphf.size_in_bits(), 4 * keys.size());
+}
+
+TEST(MinimalPerfectHashTest, ResultDoesNotDependOnThreadCount) {
+  const std::vector<std::string> keys = Keys(50000);
+  hashing::minimal_perfect_hash<std::string> serial, parallel;
+  ASSERT_TRUE(serial.build(keys.begin(), keys.end(), 2.0, 1));
+  ASSERT_TRUE(parallel.build(keys.begin(), keys.end(), 2.0, 4));
+  EXPECT_EQ(serial.serialize(), parallel.serialize());
+}
+
+TEST(MinimalPerfectHashTest, RejectsDuplicateKeys) {
+  std::vector<std::string> keys = Keys(1000);
+  keys.push_back(keys[10]);
+  hashing::minimal_perfect_hash<std::string> mphf;
+  EXPECT_FALSE(mphf.build(keys.begin(), keys.end()));
+  EXPECT_EQ(0u, mphf.size());
+}
+
+TEST(MinimalPerfectHashTest, EmptyAndSingleton) {
+  hashing::minimal_perfect_hash<std::string> mphf;
+  std::vector<std::string> keys;
+  ASSERT_TRUE(mphf.build(keys.begin(), keys.end()));
+  EXPECT_EQ(0u, mphf.size());
+  EXPECT_EQ(0u, mphf("anything"));
+
+  keys.push_back("only");
+  ASSERT_TRUE(mphf.build(keys.begin(), keys.end()));
+  EXPECT_EQ(0u, mphf("only"));
+}
+
+TEST(MinimalPerfectHashTest, SerializeRoundTrips) {
+  const std::vector<std::string> keys = Keys(20000);
+  hashing::minimal_perfect_hash<std::string> mphf, copy;
+  ASSERT_TRUE(mphf.build(keys.begin(), keys.end()));
+  const std::string bytes = mphf.serialize();
+  ASSERT_TRUE(copy.deserialize(bytes));
+  for (const std::string& key : keys) {
+    EXPECT_EQ(mphf(key), copy(key));
+  }
+  EXPECT_EQ(bytes, copy.serialize());
+
+  EXPECT_FALSE(copy.deserialize(""));
+  EXPECT_FALSE(copy.deserialize(bytes.substr(0, bytes.size() - 1)));
+  EXPECT_FALSE(copy.deserialize(bytes + "x"));
+  EXPECT_EQ(0u, copy.size());
+}
+
+}  // namespace
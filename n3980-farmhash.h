@@ -69,6 +69,8 @@ class farmhash {
 };
 
 void farmhash::operator()(const void* key, size_t length) {
+  // Empty ranges may be null, which memcpy doesn't allow.
+  if (length == 0) return;
   unsigned char* const buffer_bytes =
       reinterpret_cast<unsigned char*>(buffer_);
   const unsigned char* input_bytes =
@@ -13,14 +13,26 @@
 // limitations under the License.
 
 // Extensions to namespace std to implement N3980. Not part of this proposal,
-// but implemented as a basis for comparison. Currently contains just enough
-// to get the benchmark working.
+// but implemented as a basis for comparison. hash_append() covers the same
+// standard types as hash_value() in std_impl.h, and appends the same bytes
+// for a value as hash_combine() does, so an N3980 algorithm and a HashCode
+// built on the same kernel (e.g. hashing::n3980::farmhash and
+// hashing::farmhash) produce the same hash values.
 
 #ifndef HASHING_DEMO_N3980_H
 #define HASHING_DEMO_N3980_H
 
+#include <cstddef>
+#include <forward_list>
+#include <iterator>
+#include <memory>
 #include <string>
+#include <tuple>
 #include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "std.h"
 
@@ -28,78 +40,234 @@ namespace std_ {
 
 using std::conditional_t;
 
+// Forward declarations, so that each overload can find the others for
+// element types in namespace std, where ADL doesn't look for them.
+template <typename HashAlgorithm, typename Integral>
+enable_if_t<is_integral<Integral>::value || is_enum<Integral>::value>
+hash_append(HashAlgorithm& h, Integral value);
+
+template <typename HashAlgorithm>
+void hash_append(HashAlgorithm& h, bool value);
+
+template <typename HashAlgorithm, typename Float>
+enable_if_t<is_floating_point<Float>::value>
+hash_append(HashAlgorithm& h, Float value);
+
+template <typename HashAlgorithm, typename T>
+void hash_append(HashAlgorithm& h, T* ptr);
+
+template <typename HashAlgorithm>
+void hash_append(HashAlgorithm& h, nullptr_t);
+
+template <typename HashAlgorithm>
+void hash_append(HashAlgorithm& h, const string& str);
+
+template <typename HashAlgorithm, typename T>
+void hash_append(HashAlgorithm& h, const vector<T>& v);
+
+template <typename HashAlgorithm, typename T, size_t N>
+void hash_append(HashAlgorithm& h, const array<T, N>& a);
+
+template <typename HashAlgorithm, typename T>
+void hash_append(HashAlgorithm& h, const forward_list<T>& l);
+
+template <typename HashAlgorithm, typename K, typename H, typename E,
+          typename A>
+void hash_append(HashAlgorithm& h, const std::unordered_set<K, H, E, A>& s);
+
+template <typename HashAlgorithm, typename K, typename H, typename E,
+          typename A>
+void hash_append(HashAlgorithm& h,
+                 const std::unordered_multiset<K, H, E, A>& s);
+
+template <typename HashAlgorithm, typename K, typename V, typename H,
+          typename E, typename A>
+void hash_append(HashAlgorithm& h,
+                 const std::unordered_map<K, V, H, E, A>& m);
+
+template <typename HashAlgorithm, typename K, typename V, typename H,
+          typename E, typename A>
+void hash_append(HashAlgorithm& h,
+                 const std::unordered_multimap<K, V, H, E, A>& m);
+
+template <typename HashAlgorithm, typename T, typename D>
+void hash_append(HashAlgorithm& h, const unique_ptr<T, D>& ptr);
+
+template <typename HashAlgorithm, typename T1, typename T2>
+void hash_append(HashAlgorithm& h, const pair<T1, T2>& p);
+
+template <typename HashAlgorithm, typename... Ts>
+void hash_append(HashAlgorithm& h, const tuple<Ts...>& t);
+
 template <typename HashAlgorithm, typename T0, typename T1, typename... Ts>
 void hash_append(HashAlgorithm& h, const T0& t0, const T1& t1,
                  const Ts&... ts);
 
-  template <typename HashAlgorithm, typename Integral>
-enable_if_t<is_integral<Integral>::value || is_enum<Integral>::value>
-hash_append(HashAlgorithm& h, Integral value) {
+namespace detail {
+// Appends the bytes of 'value' to 'h'.
+template <typename HashAlgorithm, typename T>
+void hash_append_bytes(HashAlgorithm& h, const T& value) {
   h(&value, sizeof(value));
 }
 
-template <typename HashAlgorithm>
-void hash_append(HashAlgorithm& h, const string& str) {
-  h(str.data(), str.size());
-  hash_append(h, str.size());
+// Appends each element of [begin, end) to 'h', or their bytes all at once,
+// if the range is contiguous and the elements are uniquely represented.
+template <typename HashAlgorithm, typename InputIterator>
+void hash_append_range(HashAlgorithm& h, InputIterator begin,
+                       InputIterator end) {
+  if constexpr (can_hash_range_as_bytes<InputIterator>::value) {
+    if (begin != end) {
+      using std_::adl_pointer_from;
+      h(adl_pointer_from(begin), (end - begin) * sizeof(*begin));
+    }
+  } else {
+    for (; begin != end; ++begin) {
+      hash_append(h, *begin);
+    }
+  }
 }
 
-template <typename HashAlgorithm, typename T1, typename T2>
-void hash_append(HashAlgorithm& h, const pair<T1, T2>& p) {
-  hash_append(h, p.first);
-  hash_append(h, p.second);
+// As with hash_value(), containers append their size as a size_t after
+// their elements.
+template <typename HashAlgorithm, typename Container>
+void hash_append_sized_container(HashAlgorithm& h, const Container& c) {
+  hash_append_range(h, c.begin(), c.end());
+  hash_append(h, static_cast<size_t>(c.size()));
+}
+
+// Like hash_unordered_container(), each element is hashed on its own, with
+// a fresh HashAlgorithm.
+template <typename HashAlgorithm, typename Container>
+void hash_append_unordered_container(HashAlgorithm& h, const Container& c) {
+  size_t sum = 0;
+  for (const auto& value : c) {
+    HashAlgorithm element_h;
+    hash_append(element_h, value);
+    sum += static_cast<size_t>(
+        static_cast<typename HashAlgorithm::result_type>(element_h));
+  }
+  hash_append(h, sum, static_cast<size_t>(c.size()));
 }
 
-namespace detail {
 template <typename HashAlgorithm, typename Tuple, size_t... Is>
 void hash_append_tuple(
     HashAlgorithm& h, const Tuple& t, index_sequence<Is...>) {
   hash_append(h, get<Is>(t)...);
 }
+
+// The empty tuple appends nothing.
+template <typename HashAlgorithm, typename Tuple>
+void hash_append_tuple(HashAlgorithm&, const Tuple&, index_sequence<>) {}
 }  // namespace detail
 
-template <typename HashAlgorithm, typename... Ts>
-void hash_append(HashAlgorithm& h, const tuple<Ts...>& t) {
-  detail::hash_append_tuple(h, t, make_index_sequence<sizeof...(Ts)>());
+template <typename HashAlgorithm, typename Integral>
+enable_if_t<is_integral<Integral>::value || is_enum<Integral>::value>
+hash_append(HashAlgorithm& h, Integral value) {
+  detail::hash_append_bytes(h, value);
 }
 
-namespace detail {
-struct hash_bytes_directly_tag {};
-struct hash_by_iterating_tag {};
+template <typename HashAlgorithm>
+void hash_append(HashAlgorithm& h, bool value) {
+  hash_append(h, static_cast<unsigned char>(value ? 1 : 0));
+}
 
-template <typename C>
-struct select_hash_iteration_strategy {
-  using type = hash_by_iterating_tag;
-};
+template <typename HashAlgorithm, typename Float>
+enable_if_t<is_floating_point<Float>::value>
+hash_append(HashAlgorithm& h, Float value) {
+  // Make 0.0 and -0.0 hash equally, as they compare equal.
+  const Float canonical = value == 0 ? 0 : value;
+  detail::hash_append_bytes(h, canonical);
+}
 
-template <typename T>
-struct select_hash_iteration_strategy<vector<T>> {
-  using type = conditional_t<is_uniquely_represented<T>::value,
-                             hash_bytes_directly_tag, hash_by_iterating_tag>;
-};
+template <typename HashAlgorithm, typename T>
+void hash_append(HashAlgorithm& h, T* ptr) {
+  detail::hash_append_bytes(h, ptr);
+}
 
-template <typename HashAlgorithm, typename C>
-void hash_append_container(
-    HashAlgorithm& h, const C& c, hash_bytes_directly_tag) {
-  if (!c.empty()) {
-    h(&*c.begin(), c.size() * sizeof(*c.begin()));
-  }
-  hash_append(h, static_cast<size_t>(c.size()));
+template <typename HashAlgorithm>
+void hash_append(HashAlgorithm& h, nullptr_t) {
+  hash_append(h, static_cast<unsigned char>(0));
 }
 
-template <typename HashAlgorithm, typename C>
-void hash_append_container(
-    HashAlgorithm& h, const C& c, hash_by_iterating_tag) {
-  for (const auto& v : c) {
-    hash_append(h, v);
-  }
+template <typename HashAlgorithm>
+void hash_append(HashAlgorithm& h, const string& str) {
+  detail::hash_append_sized_container(h, str);
 }
-}  // namespace detail
 
 template <typename HashAlgorithm, typename T>
 void hash_append(HashAlgorithm& h, const vector<T>& v) {
-  detail::hash_append_container(
-      h, v, typename detail::select_hash_iteration_strategy<vector<T>>::type());
+  detail::hash_append_sized_container(h, v);
+}
+
+template <typename HashAlgorithm, typename T, size_t N>
+void hash_append(HashAlgorithm& h, const array<T, N>& a) {
+  // Like hash_combine(), hash a uniquely-represented array as its bytes,
+  // without the size, which is part of the type.
+  if constexpr (is_uniquely_represented<array<T, N>>::value) {
+    detail::hash_append_bytes(h, a);
+  } else {
+    detail::hash_append_sized_container(h, a);
+  }
+}
+
+template <typename HashAlgorithm, typename T>
+void hash_append(HashAlgorithm& h, const forward_list<T>& l) {
+  size_t size = 0;
+  for (const T& t : l) {
+    hash_append(h, t);
+    ++size;
+  }
+  hash_append(h, size);
+}
+
+template <typename HashAlgorithm, typename K, typename H, typename E,
+          typename A>
+void hash_append(HashAlgorithm& h, const std::unordered_set<K, H, E, A>& s) {
+  detail::hash_append_unordered_container(h, s);
+}
+
+template <typename HashAlgorithm, typename K, typename H, typename E,
+          typename A>
+void hash_append(HashAlgorithm& h,
+                 const std::unordered_multiset<K, H, E, A>& s) {
+  detail::hash_append_unordered_container(h, s);
+}
+
+template <typename HashAlgorithm, typename K, typename V, typename H,
+          typename E, typename A>
+void hash_append(HashAlgorithm& h,
+                 const std::unordered_map<K, V, H, E, A>& m) {
+  detail::hash_append_unordered_container(h, m);
+}
+
+template <typename HashAlgorithm, typename K, typename V, typename H,
+          typename E, typename A>
+void hash_append(HashAlgorithm& h,
+                 const std::unordered_multimap<K, V, H, E, A>& m) {
+  detail::hash_append_unordered_container(h, m);
+}
+
+template <typename HashAlgorithm, typename T, typename D>
+void hash_append(HashAlgorithm& h, const unique_ptr<T, D>& ptr) {
+  hash_append(h, ptr.get());
+}
+
+template <typename HashAlgorithm, typename T1, typename T2>
+void hash_append(HashAlgorithm& h, const pair<T1, T2>& p) {
+  if constexpr (is_uniquely_represented<pair<T1, T2>>::value) {
+    detail::hash_append_bytes(h, p);
+  } else {
+    hash_append(h, p.first, p.second);
+  }
+}
+
+template <typename HashAlgorithm, typename... Ts>
+void hash_append(HashAlgorithm& h, const tuple<Ts...>& t) {
+  if constexpr (is_uniquely_represented<tuple<Ts...>>::value) {
+    detail::hash_append_bytes(h, t);
+  } else {
+    detail::hash_append_tuple(h, t, make_index_sequence<sizeof...(Ts)>());
+  }
 }
 
 template <typename HashAlgorithm, typename T0, typename T1, typename... Ts>
@@ -114,7 +282,7 @@ struct uhash {
   using result_type = typename H::result_type;
 
   template <typename T>
-  result_type operator()(const T& t) {
+  result_type operator()(const T& t) const {
     H h;
     hash_append(h, t);
     return static_cast<result_type>(h);
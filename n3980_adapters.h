@@ -0,0 +1,134 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Adapters between N3980 HashAlgorithms and HashCodes, so that a hashing
+// kernel only needs to be written in one of the two forms. Not part of this
+// proposal.
+
+#ifndef HASHING_DEMO_N3980_ADAPTERS_H
+#define HASHING_DEMO_N3980_ADAPTERS_H
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "std_impl.h"
+
+namespace hashing {
+
+// A HashCode that passes the bytes it's given to an N3980 HashAlgorithm,
+// i.e. a default-constructible type with operator()(const void*, size_t)
+// and an explicit conversion to result_type. Like farmhash, it points to
+// its state, so the algorithm isn't copied as the HashCode is passed by
+// value:
+//
+//   hash_code_adapter<n3980::farmhash>::state_type state;
+//   size_t hash = size_t(hash_combine(
+//       hash_code_adapter<n3980::farmhash>(&state), values...));
+//
+// Since hash_combine() and hash_append() produce the same bytes for the
+// same value, this computes the same hash as hash_append() with
+// HashAlgorithm.
+template <typename HashAlgorithm>
+class hash_code_adapter {
+ public:
+  using result_type = typename HashAlgorithm::result_type;
+  using state_type = HashAlgorithm;
+
+  explicit hash_code_adapter(state_type* state) : state_(state) {}
+
+  // Move only
+  hash_code_adapter(const hash_code_adapter&) = delete;
+  hash_code_adapter& operator=(const hash_code_adapter&) = delete;
+  hash_code_adapter(hash_code_adapter&&) = default;
+  hash_code_adapter& operator=(hash_code_adapter&&) = default;
+
+  template <typename... Ts>
+  friend hash_code_adapter hash_combine(hash_code_adapter hash_code,
+                                        const Ts&... values) {
+    return std_::simple_hash_combine(std::move(hash_code), values...);
+  }
+
+  template <typename InputIterator>
+  friend hash_code_adapter hash_combine_range(
+      hash_code_adapter hash_code, InputIterator begin, InputIterator end) {
+    return std_::simple_hash_combine_range(std::move(hash_code), begin, end);
+  }
+
+  friend hash_code_adapter hash_combine_range(
+      hash_code_adapter hash_code, const unsigned char* begin,
+      const unsigned char* end) {
+    (*hash_code.state_)(begin, end - begin);
+    return hash_code;
+  }
+
+  explicit operator result_type() && {
+    return static_cast<result_type>(*state_);
+  }
+
+ private:
+  state_type* state_;
+};
+
+namespace detail {
+
+// Holds a HashCode and whatever state it points to. HashCodes with a
+// state_type, like farmhash, are constructed from a pointer to it, and the
+// rest are default-constructed.
+template <typename HashCode, typename = void>
+struct hash_code_holder {
+  HashCode code;
+};
+
+template <typename HashCode>
+struct hash_code_holder<HashCode,
+                        std::void_t<typename HashCode::state_type>> {
+  typename HashCode::state_type state;
+  HashCode code{&state};
+};
+
+}  // namespace detail
+
+// An N3980 HashAlgorithm that passes the bytes it's given to a HashCode, so
+// that e.g. std_::uhash<hash_algorithm_adapter<farmhash>> can hash types
+// that only provide hash_append(). The HashCode is kept in place, so this
+// is neither copyable nor movable when HashCode has a state_type, but
+// std_::uhash never copies or moves its algorithm.
+//
+// Converting to result_type consumes the HashCode, so it may only be done
+// once.
+template <typename HashCode>
+class hash_algorithm_adapter {
+ public:
+  using result_type = typename HashCode::result_type;
+
+  hash_algorithm_adapter() {}
+
+  void operator()(const void* key, size_t length) {
+    const auto* bytes = static_cast<const unsigned char*>(key);
+    holder_.code =
+        hash_combine_range(std::move(holder_.code), bytes, bytes + length);
+  }
+
+  explicit operator result_type() {
+    return static_cast<result_type>(std::move(holder_.code));
+  }
+
+ private:
+  detail::hash_code_holder<HashCode> holder_;
+};
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_N3980_ADAPTERS_H
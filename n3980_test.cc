@@ -0,0 +1,155 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests that hash_append() appends the same bytes as hash_combine(), so
+// that the two frameworks agree when they use the same kernel.
+
+#include <array>
+#include <forward_list>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "farmhash.h"
+#include "fnv1a.h"
+#include "n3980-farmhash.h"
+#include "n3980.h"
+#include "n3980_adapters.h"
+#include "std.h"
+
+namespace {
+
+template <typename T>
+size_t HashCombine(const T& value) {
+  hashing::farmhash::state_type state;
+  return hashing::farmhash::result_type(
+      hash_combine(hashing::farmhash(&state), value));
+}
+
+template <typename T>
+size_t HashAppend(const T& value) {
+  return std_::uhash<hashing::n3980::farmhash>{}(value);
+}
+
+template <typename T>
+void ExpectParity(const T& value) {
+  EXPECT_EQ(HashCombine(value), HashAppend(value));
+}
+
+struct Padded {
+  char c;
+  int i;
+};
+
+template <typename HashCode>
+HashCode hash_value(HashCode code, const Padded& p) {
+  return hash_combine(std::move(code), p.c, p.i);
+}
+
+template <typename HashAlgorithm>
+void hash_append(HashAlgorithm& h, const Padded& p) {
+  using std_::hash_append;
+  hash_append(h, p.c, p.i);
+}
+
+TEST(N3980Test, ScalarsMatchHashCombine) {
+  ExpectParity(42);
+  ExpectParity(static_cast<unsigned char>(7));
+  ExpectParity(-1L);
+  ExpectParity(true);
+  ExpectParity(false);
+  ExpectParity(1.5);
+  ExpectParity(2.5f);
+  int x = 0;
+  ExpectParity(&x);
+  ExpectParity(nullptr);
+}
+
+TEST(N3980Test, FloatingPointZerosAreEqual) {
+  EXPECT_EQ(HashAppend(0.0), HashAppend(-0.0));
+}
+
+TEST(N3980Test, ContainersMatchHashCombine) {
+  ExpectParity(std::string("hello, world"));
+  ExpectParity(std::vector<int>{1, 2, 3});
+  ExpectParity(std::vector<std::string>{"a", "bc", ""});
+  ExpectParity(std::vector<Padded>{{'a', 1}, {'b', 2}});
+  ExpectParity(std::array<int, 3>{{4, 5, 6}});
+  ExpectParity(std::array<Padded, 2>{{{'a', 1}, {'b', 2}}});
+  ExpectParity(std::forward_list<int>{1, 2, 3});
+  ExpectParity(std::unordered_set<int>{1, 2, 3});
+  ExpectParity(std::unordered_multiset<int>{1, 1, 2});
+  ExpectParity(std::unordered_map<std::string, int>{{"a", 1}, {"b", 2}});
+  ExpectParity(std::unordered_multimap<int, int>{{1, 1}, {1, 2}});
+  ExpectParity(std::vector<std::vector<int>>{{1}, {2, 3}, {}});
+}
+
+TEST(N3980Test, CompositesMatchHashCombine) {
+  ExpectParity(std::make_pair(1, 2));
+  ExpectParity(std::make_pair('a', 2));
+  ExpectParity(std::make_pair(std::string("a"), 2.5));
+  ExpectParity(std::make_tuple(short(1), 'a', 'b'));
+  ExpectParity(std::make_tuple(1, std::string("b"), true));
+  ExpectParity(std::tuple<>());
+  ExpectParity(std::unique_ptr<int>(new int(5)));
+  ExpectParity(Padded{'z', 26});
+}
+
+TEST(N3980Test, ContainerSizeIsAppended) {
+  // Without the size, these would append the same bytes.
+  using Nested = std::vector<std::vector<int>>;
+  EXPECT_NE(HashAppend(Nested{{1, 2}, {}}), HashAppend(Nested{{1}, {2}}));
+}
+
+// The adapters compute the same hashes as the kernels they wrap, since all
+// four combinations see the same bytes.
+template <typename T>
+void ExpectAdaptersMatch(const T& value) {
+  using AdaptedCode = hashing::hash_code_adapter<hashing::n3980::farmhash>;
+  AdaptedCode::state_type state;
+  EXPECT_EQ(HashCombine(value),
+            AdaptedCode::result_type(hash_combine(AdaptedCode(&state), value)));
+  EXPECT_EQ(
+      HashAppend(value),
+      std_::uhash<hashing::hash_algorithm_adapter<hashing::farmhash>>{}(
+          value));
+}
+
+TEST(N3980Test, AdaptersMatchUnderlyingKernels) {
+  ExpectAdaptersMatch(42);
+  ExpectAdaptersMatch(1.5);
+  ExpectAdaptersMatch(std::string(200, 'x'));
+  ExpectAdaptersMatch(std::vector<Padded>{{'a', 1}, {'b', 2}});
+  ExpectAdaptersMatch(std::make_tuple(1, std::string("b"), true));
+  ExpectAdaptersMatch(std::unordered_set<int>{1, 2, 3});
+}
+
+TEST(N3980Test, AlgorithmAdapterWrapsDefaultConstructibleHashCode) {
+  const std::string s = "hello, world";
+  hashing::fnv1a::result_type expected;
+  {
+    using std_::hash_value;
+    expected = hashing::fnv1a::result_type(hash_value(hashing::fnv1a(), s));
+  }
+  EXPECT_EQ(expected,
+            std_::uhash<hashing::hash_algorithm_adapter<hashing::fnv1a>>{}(s));
+}
+
+}  // namespace
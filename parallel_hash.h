@@ -0,0 +1,74 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Multi-threaded computation of std_::hash for large unordered containers.
+// Not part of this proposal.
+
+#ifndef HASHING_DEMO_PARALLEL_HASH_H
+#define HASHING_DEMO_PARALLEL_HASH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "std.h"
+
+namespace hashing {
+
+// Returns std_::hash<Container>{}(container), for an unordered container,
+// using up to 'num_threads' threads. Since the hash of an unordered
+// container is built from a sum of independent element hashes, the buckets
+// can be split among threads, and the partial sums added at the end.
+template <typename Container>
+size_t parallel_unordered_hash(
+    const Container& container,
+    unsigned num_threads = std::thread::hardware_concurrency()) {
+  using value_type = typename Container::value_type;
+  const size_t num_buckets = container.bucket_count();
+  num_threads = std::max(1u, std::min<unsigned>(num_threads, num_buckets));
+
+  std::vector<size_t> partial_sums(num_threads);
+  auto hash_buckets = [&](unsigned thread) {
+    const size_t first = num_buckets * thread / num_threads;
+    const size_t last = num_buckets * (thread + 1) / num_threads;
+    size_t sum = 0;
+    for (size_t b = first; b < last; ++b) {
+      for (auto it = container.begin(b); it != container.end(b); ++it) {
+        sum += std_::hash<value_type>{}(*it);
+      }
+    }
+    partial_sums[thread] = sum;
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned thread = 1; thread < num_threads; ++thread) {
+    threads.emplace_back(hash_buckets, thread);
+  }
+  hash_buckets(0);
+  size_t sum = 0;
+  for (unsigned thread = 0; thread < num_threads; ++thread) {
+    if (thread != 0) threads[thread - 1].join();
+    sum += partial_sums[thread];
+  }
+
+  // Finish the same way as std_::detail::hash_unordered_container.
+  farmhash::state_type state;
+  return farmhash::result_type(hash_combine(
+      farmhash(&state), sum, static_cast<size_t>(container.size())));
+}
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_PARALLEL_HASH_H
@@ -14,7 +14,9 @@
 
 #include "pimpl.h"
 
+#include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
 
 class Impl {
@@ -24,15 +26,44 @@ class Impl {
  public:
   Impl() {}
 
-  friend hashing::type_erased_hash_code hash_value(
-      hashing::type_erased_hash_code hash_code, const Impl& impl);
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode hash_code, const Impl& impl);
 };
 
-hashing::type_erased_hash_code hash_value(
-    hashing::type_erased_hash_code hash_code, const Impl& impl) {
+template <typename HashCode>
+HashCode hash_value(HashCode hash_code, const Impl& impl) {
   return hash_combine(std::move(hash_code), impl.v_, impl.s_);
 }
 
+template hashing::type_erased_hash_code hash_value(
+    hashing::type_erased_hash_code hash_code, const Impl& impl);
+template hashing::farmhash hash_value(
+    hashing::farmhash hash_code, const Impl& impl);
+
 Pimpl::Pimpl() :impl_(std::make_unique<Impl>()) {}
 
 Pimpl::~Pimpl() {}
+
+class WideImpl {
+  WideFields fields_;
+
+ public:
+  WideImpl() {}
+
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode hash_code, const WideImpl& impl);
+};
+
+template <typename HashCode>
+HashCode hash_value(HashCode hash_code, const WideImpl& impl) {
+  return hash_value(std::move(hash_code), impl.fields_);
+}
+
+template hashing::type_erased_hash_code hash_value(
+    hashing::type_erased_hash_code hash_code, const WideImpl& impl);
+template hashing::farmhash hash_value(
+    hashing::farmhash hash_code, const WideImpl& impl);
+
+WidePimpl::WidePimpl() : impl_(std::make_unique<WideImpl>()) {}
+
+WidePimpl::~WidePimpl() {}
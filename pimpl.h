@@ -15,13 +15,35 @@
 #ifndef HASHING_DEMO_PIMPL_H
 #define HASHING_DEMO_PIMPL_H
 
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "farmhash.h"
 #include "type_erased_hash_code.h"
 
+// Impl's hash_value() is defined in pimpl.cc, and instantiated there for
+// type_erased_hash_code, which handles every HashCode, and for
+// hashing::farmhash, which std_::hash uses and which can therefore skip
+// the type erasure.
+//
+// pimpl_direct_hash_codes lists the HashCodes other than
+// type_erased_hash_code that the hash_value()s are instantiated for; both
+// the hash_value() dispatch and the is_hashed_via_type_erasure
+// specializations below are derived from it. Adding a HashCode to it
+// without instantiating the hash_value()s for it in pimpl.cc fails to link.
+using pimpl_direct_hash_codes = hashing::direct_hash_codes<hashing::farmhash>;
+
 class Impl;
-hashing::type_erased_hash_code hash_value(
+template <typename HashCode>
+HashCode hash_value(HashCode hash_code, const Impl& impl);
+extern template hashing::type_erased_hash_code hash_value(
     hashing::type_erased_hash_code hash_code, const Impl& impl);
+extern template hashing::farmhash hash_value(
+    hashing::farmhash hash_code, const Impl& impl);
 
 class Pimpl {
   std::unique_ptr<Impl> impl_;
@@ -32,9 +54,73 @@ class Pimpl {
 
   template <typename HashCode>
   friend HashCode hash_value(HashCode hash_code, const Pimpl& pimpl) {
-    hash_value(hashing::type_erased_hash_code(&hash_code), *pimpl.impl_);
-    return std::move(hash_code);
+    return pimpl_direct_hash_codes::hash_value_out_of_line(
+        std::move(hash_code), *pimpl.impl_);
+  }
+};
+
+// The fields of WidePimpl's implementation: many small ones, each of which
+// is combined separately. Tests and benchmarks hash it directly, as the
+// inline equivalent of WidePimpl.
+struct WideFields {
+  int32_t id = 42;
+  int16_t year = 2015;
+  uint8_t month = 6;
+  uint8_t day = 30;
+  bool active = true;
+  double score = 0.5;
+  int64_t timestamp = 1435622400;
+  std::string name = "wide";
+  std::vector<std::pair<char, int>> tags = {
+      {'a', 1}, {'b', 2}, {'c', 3}, {'d', 4}, {'e', 5}, {'f', 6},
+      {'g', 7}, {'h', 8}, {'i', 9}, {'j', 10}, {'k', 11}, {'l', 12}};
+  std::string description = std::string(200, 'x');
+
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode hash_code, const WideFields& f) {
+    return hash_combine(std::move(hash_code), f.id, f.year, f.month, f.day,
+                        f.active, f.score, f.timestamp, f.name, f.tags,
+                        f.description);
   }
 };
 
+// Like Pimpl, but its implementation is a WideFields.
+class WideImpl;
+template <typename HashCode>
+HashCode hash_value(HashCode hash_code, const WideImpl& impl);
+extern template hashing::type_erased_hash_code hash_value(
+    hashing::type_erased_hash_code hash_code, const WideImpl& impl);
+extern template hashing::farmhash hash_value(
+    hashing::farmhash hash_code, const WideImpl& impl);
+
+class WidePimpl {
+  std::unique_ptr<WideImpl> impl_;
+
+ public:
+  WidePimpl();
+  ~WidePimpl();
+
+  template <typename HashCode>
+  friend HashCode hash_value(HashCode hash_code, const WidePimpl& pimpl) {
+    return pimpl_direct_hash_codes::hash_value_out_of_line(
+        std::move(hash_code), *pimpl.impl_);
+  }
+};
+
+// Pimpl and WidePimpl are hashed out of line, and so via type erasure for
+// every HashCode but pimpl_direct_hash_codes.
+namespace std_ {
+
+template <typename HashCode>
+struct is_hashed_via_type_erasure<Pimpl, HashCode>
+    : public integral_constant<
+          bool, !pimpl_direct_hash_codes::contains<HashCode>()> {};
+
+template <typename HashCode>
+struct is_hashed_via_type_erasure<WidePimpl, HashCode>
+    : public integral_constant<
+          bool, !pimpl_direct_hash_codes::contains<HashCode>()> {};
+
+}  // namespace std_
+
 #endif  // HASHING_DEMO_PIMPL_H
@@ -0,0 +1,208 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Gear rolling hash, and a content-defined chunker built on it, for
+// deduplicating byte streams. Not part of this proposal.
+
+#ifndef HASHING_DEMO_ROLLING_HASH_H
+#define HASHING_DEMO_ROLLING_HASH_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "farmhash.h"
+#include "hash_util.h"
+#include "std_impl.h"
+
+namespace hashing {
+
+namespace detail {
+// Returns 256 pseudo-random 64-bit values, generated with SplitMix64 so
+// that the table is fixed at compile time.
+constexpr std::array<uint64_t, 256> make_gear_table() {
+  std::array<uint64_t, 256> table{};
+  uint64_t x = 0;
+  for (size_t i = 0; i < table.size(); ++i) {
+    table[i] = splitmix64(&x);
+  }
+  return table;
+}
+
+inline constexpr std::array<uint64_t, 256> kGearTable = make_gear_table();
+}  // namespace detail
+
+// HashCode implementing the Gear rolling hash (Xia et al., "Ddelta"). Each
+// byte shifts the state left by one bit and adds a random value for that
+// byte, so the state depends only on the last 64 bytes of input. This makes
+// it a poor general-purpose hash, but lets it find content-defined
+// boundaries in a single pass, at about one add and one shift per byte.
+class gear_hash {
+  uint64_t state_ = 0;
+
+ public:
+  using result_type = size_t;
+
+  gear_hash() {}
+
+  // Mixes one byte into 'state' and returns the result. This is the entire
+  // algorithm; it's exposed so that tight loops such as the chunker below
+  // can keep the state in a register.
+  static uint64_t roll(uint64_t state, unsigned char c) {
+    return (state << 1) + detail::kGearTable[c];
+  }
+
+  template <typename T, typename... Ts>
+  friend gear_hash hash_combine(gear_hash hash_code, const T& value,
+                                const Ts&... values) {
+    return hash_combine(
+        std_::simple_hash_combine(hash_code, value), values...);
+  }
+
+  friend gear_hash hash_combine(gear_hash hash_code) { return hash_code; }
+
+  template <typename InputIterator>
+  friend gear_hash hash_combine_range(
+      gear_hash hash_code, InputIterator begin, InputIterator end) {
+    return std_::simple_hash_combine_range(hash_code, begin, end);
+  }
+
+  friend gear_hash hash_combine_range(
+      gear_hash hash_code, const unsigned char* begin,
+      const unsigned char* end) {
+    uint64_t state = hash_code.state_;
+    for (; begin != end; ++begin) {
+      state = roll(state, *begin);
+    }
+    hash_code.state_ = state;
+    return hash_code;
+  }
+
+  explicit operator result_type() && noexcept { return state_; }
+};
+
+// Splits byte buffers into chunks whose boundaries depend only on nearby
+// content, so that an insertion or deletion only changes the chunks around
+// it, and the rest of the stream deduplicates against earlier copies.
+//
+// This follows FastCDC (Xia et al., 2016): no boundary is considered in
+// the first min_size bytes of a chunk, a boundary is declared where the
+// top bits of the Gear hash are zero, and the number of bits tested is
+// larger before avg_size than after it, which concentrates chunk sizes
+// around avg_size. Chunks never exceed max_size.
+class content_defined_chunker {
+ public:
+  struct chunk {
+    size_t offset;
+    size_t length;
+    // hashing::farmhash of the chunk's bytes.
+    size_t fingerprint;
+  };
+
+  // avg_size must be a power of two.
+  explicit content_defined_chunker(size_t min_size = 2 * 1024,
+                                   size_t avg_size = 8 * 1024,
+                                   size_t max_size = 64 * 1024)
+      : min_size_(min_size), avg_size_(avg_size), max_size_(max_size) {
+    assert(min_size <= avg_size && avg_size <= max_size);
+    assert(avg_size != 0 && (avg_size & (avg_size - 1)) == 0);
+    int bits = 0;
+    while ((size_t{1} << bits) < avg_size) ++bits;
+    // Only the top bits of the state depend on the whole 64-byte window;
+    // the low bits depend on just the last few bytes. So we test the top
+    // bits.
+    strict_mask_ = top_bits(bits + 2);
+    loose_mask_ = top_bits(bits > 2 ? bits - 2 : 1);
+  }
+
+  // Returns the length of the chunk that starts at 'begin'. If the chunk
+  // would extend past 'end', returns end - begin, i.e. the rest of the
+  // buffer is the final chunk.
+  size_t next_cut(const unsigned char* begin, const unsigned char* end) const {
+    const size_t size = end - begin;
+    if (size <= min_size_) return size;
+    const size_t normal_end = std::min(size, avg_size_);
+    const size_t hard_end = std::min(size, max_size_);
+    uint64_t state = 0;
+    size_t i = min_size_;
+    for (; i < normal_end; ++i) {
+      state = gear_hash::roll(state, begin[i]);
+      if ((state & strict_mask_) == 0) return i + 1;
+    }
+    for (; i < hard_end; ++i) {
+      state = gear_hash::roll(state, begin[i]);
+      if ((state & loose_mask_) == 0) return i + 1;
+    }
+    return hard_end;
+  }
+
+  // Calls on_chunk(chunk_begin, chunk_end) for each chunk of
+  // [begin, end), in order.
+  template <typename F>
+  void for_each_chunk(const unsigned char* begin, const unsigned char* end,
+                      F on_chunk) const {
+    while (begin != end) {
+      const unsigned char* cut = begin + next_cut(begin, end);
+      on_chunk(begin, cut);
+      begin = cut;
+    }
+  }
+
+  // Returns the end offsets of all chunks of [begin, end).
+  std::vector<size_t> cut_points(const unsigned char* begin,
+                                 const unsigned char* end) const {
+    std::vector<size_t> cuts;
+    for_each_chunk(begin, end,
+                   [&](const unsigned char*, const unsigned char* cut) {
+                     cuts.push_back(cut - begin);
+                   });
+    return cuts;
+  }
+
+  // Returns all chunks of [begin, end), each fingerprinted with
+  // hashing::farmhash.
+  std::vector<chunk> chunks(const unsigned char* begin,
+                            const unsigned char* end) const {
+    std::vector<chunk> result;
+    for_each_chunk(begin, end, [&](const unsigned char* chunk_begin,
+                                   const unsigned char* chunk_end) {
+      farmhash::state_type state;
+      result.push_back(chunk{
+          size_t(chunk_begin - begin), size_t(chunk_end - chunk_begin),
+          farmhash::result_type(hash_combine_range(
+              farmhash(&state), chunk_begin, chunk_end))});
+    });
+    return result;
+  }
+
+  size_t min_size() const { return min_size_; }
+  size_t avg_size() const { return avg_size_; }
+  size_t max_size() const { return max_size_; }
+
+ private:
+  static uint64_t top_bits(int n) { return ~uint64_t{0} << (64 - n); }
+
+  size_t min_size_;
+  size_t avg_size_;
+  size_t max_size_;
+  uint64_t strict_mask_;
+  uint64_t loose_mask_;
+};
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_ROLLING_HASH_H
@@ -0,0 +1,134 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "rolling_hash.h"
+
+namespace {
+
+std::vector<unsigned char> RandomBytes(size_t size, unsigned seed = 0) {
+  std::independent_bits_engine<std::default_random_engine, 8, unsigned char>
+      engine(seed);
+  std::vector<unsigned char> bytes(size);
+  std::generate(bytes.begin(), bytes.end(), engine);
+  return bytes;
+}
+
+size_t GearHash(const unsigned char* begin, const unsigned char* end) {
+  return size_t(hash_combine_range(hashing::gear_hash{}, begin, end));
+}
+
+TEST(GearHashTest, DependsOnlyOnLast64Bytes) {
+  const std::vector<unsigned char> a = RandomBytes(200, 1);
+  std::vector<unsigned char> b = RandomBytes(200, 2);
+  std::copy(a.end() - 64, a.end(), b.end() - 64);
+  EXPECT_EQ(GearHash(a.data(), a.data() + a.size()),
+            GearHash(b.data(), b.data() + b.size()));
+  EXPECT_NE(GearHash(a.data(), a.data() + a.size() - 1),
+            GearHash(b.data(), b.data() + b.size() - 1));
+}
+
+TEST(GearHashTest, SplitInputIsEquivalent) {
+  const std::vector<unsigned char> bytes = RandomBytes(100);
+  hashing::gear_hash code;
+  code = hash_combine_range(code, bytes.data(), bytes.data() + 30);
+  code = hash_combine_range(code, bytes.data() + 30, bytes.data() + 100);
+  EXPECT_EQ(GearHash(bytes.data(), bytes.data() + bytes.size()),
+            size_t(std::move(code)));
+}
+
+TEST(ContentDefinedChunkerTest, ChunksCoverInputWithinSizeLimits) {
+  const std::vector<unsigned char> bytes = RandomBytes(1 << 20);
+  hashing::content_defined_chunker chunker(1024, 4096, 16384);
+  const auto chunks = chunker.chunks(bytes.data(), bytes.data() + bytes.size());
+  ASSERT_GT(chunks.size(), 1u);
+  size_t offset = 0;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    SCOPED_TRACE(i);
+    EXPECT_EQ(offset, chunks[i].offset);
+    EXPECT_LE(chunks[i].length, 16384u);
+    if (i + 1 != chunks.size()) {
+      EXPECT_GT(chunks[i].length, 1024u);
+    }
+    offset += chunks[i].length;
+  }
+  EXPECT_EQ(bytes.size(), offset);
+  // The mean chunk size should be in the neighbourhood of avg_size.
+  const double mean = double(bytes.size()) / chunks.size();
+  EXPECT_GT(mean, 2048);
+  EXPECT_LT(mean, 8192);
+}
+
+TEST(ContentDefinedChunkerTest, CutPointsMatchChunks) {
+  const std::vector<unsigned char> bytes = RandomBytes(100000);
+  hashing::content_defined_chunker chunker(256, 1024, 4096);
+  const auto cuts =
+      chunker.cut_points(bytes.data(), bytes.data() + bytes.size());
+  const auto chunks = chunker.chunks(bytes.data(), bytes.data() + bytes.size());
+  ASSERT_EQ(cuts.size(), chunks.size());
+  for (size_t i = 0; i < cuts.size(); ++i) {
+    EXPECT_EQ(cuts[i], chunks[i].offset + chunks[i].length);
+  }
+}
+
+TEST(ContentDefinedChunkerTest, FingerprintIsFarmhashOfChunk) {
+  const std::vector<unsigned char> bytes = RandomBytes(50000);
+  hashing::content_defined_chunker chunker(256, 1024, 4096);
+  for (const auto& c :
+       chunker.chunks(bytes.data(), bytes.data() + bytes.size())) {
+    hashing::farmhash::state_type state;
+    const unsigned char* begin = bytes.data() + c.offset;
+    EXPECT_EQ(size_t(hash_combine_range(hashing::farmhash(&state), begin,
+                                        begin + c.length)),
+              c.fingerprint);
+  }
+}
+
+TEST(ContentDefinedChunkerTest, InsertionOnlyAffectsNearbyChunks) {
+  const std::vector<unsigned char> original = RandomBytes(1 << 20);
+  std::vector<unsigned char> edited = original;
+  const std::vector<unsigned char> insertion = RandomBytes(100, 7);
+  edited.insert(edited.begin() + 500000, insertion.begin(), insertion.end());
+
+  hashing::content_defined_chunker chunker;
+  std::set<size_t> original_fingerprints;
+  for (const auto& c :
+       chunker.chunks(original.data(), original.data() + original.size())) {
+    original_fingerprints.insert(c.fingerprint);
+  }
+  const auto edited_chunks =
+      chunker.chunks(edited.data(), edited.data() + edited.size());
+  size_t new_chunks = 0;
+  for (const auto& c : edited_chunks) {
+    new_chunks += original_fingerprints.count(c.fingerprint) == 0;
+  }
+  EXPECT_GE(new_chunks, 1u);
+  EXPECT_LE(new_chunks, 3u);
+}
+
+TEST(ContentDefinedChunkerTest, ShortInput) {
+  const std::vector<unsigned char> bytes = RandomBytes(100);
+  hashing::content_defined_chunker chunker;
+  EXPECT_EQ(std::vector<size_t>{100},
+            chunker.cut_points(bytes.data(), bytes.data() + bytes.size()));
+  EXPECT_TRUE(chunker.cut_points(bytes.data(), bytes.data()).empty());
+}
+
+}  // namespace
@@ -0,0 +1,210 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Similarity sketches (MinHash and SimHash) over token streams of any type
+// that std_::hash supports, and a locality-sensitive hashing index for
+// finding near-duplicates among MinHash signatures. Not part of this
+// proposal.
+
+#ifndef HASHING_DEMO_SIMILARITY_H
+#define HASHING_DEMO_SIMILARITY_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "farmhash.h"
+#include "hash_util.h"
+#include "std.h"
+
+namespace hashing {
+
+// Computes MinHash signatures (Broder, "On the resemblance and containment
+// of documents"). The fraction of positions at which the signatures of two
+// token sets agree estimates their Jaccard similarity, with a standard
+// error of about 1/sqrt(num_hashes).
+//
+// Each token is hashed once with Hash. The num_hashes hash functions are
+// then derived from that value by cheap seeded bijections (an add, a
+// multiply by an odd constant, and an xor-shift), computed in a loop over
+// the signature that the compiler can vectorize.
+template <typename Token, typename Hash = std_::hash<Token>>
+class minhash {
+ public:
+  explicit minhash(size_t num_hashes = 128, uint64_t seed = 0,
+                   Hash hash = Hash())
+      : offsets_(num_hashes), multipliers_(num_hashes),
+        hash_(std::move(hash)) {
+    // SplitMix64, to derive the per-function constants from 'seed'.
+    uint64_t x = seed;
+    for (size_t i = 0; i < num_hashes; ++i) {
+      offsets_[i] = splitmix64(&x);
+      multipliers_[i] = splitmix64(&x) | 1;
+    }
+  }
+
+  size_t num_hashes() const { return offsets_.size(); }
+
+  // Returns the signature of the set of tokens in [begin, end). Repeated
+  // tokens and token order don't affect the result.
+  template <typename InputIterator>
+  std::vector<uint64_t> signature(InputIterator begin,
+                                  InputIterator end) const {
+    std::vector<uint64_t> result(num_hashes(),
+                                 std::numeric_limits<uint64_t>::max());
+    for (; begin != end; ++begin) {
+      add_hash(static_cast<uint64_t>(hash_(*begin)), &result);
+    }
+    return result;
+  }
+
+  template <typename Range>
+  std::vector<uint64_t> signature(const Range& tokens) const {
+    using std::begin;
+    using std::end;
+    return signature(begin(tokens), end(tokens));
+  }
+
+  // Updates 'signature', which must have num_hashes() entries, to include a
+  // token with the given hash. A signature of all ~0 is the empty set.
+  void add_hash(uint64_t token_hash, std::vector<uint64_t>* signature) const {
+    assert(signature->size() == num_hashes());
+    uint64_t* sig = signature->data();
+    const uint64_t* offsets = offsets_.data();
+    const uint64_t* multipliers = multipliers_.data();
+    for (size_t i = 0, n = offsets_.size(); i < n; ++i) {
+      uint64_t h = (token_hash + offsets[i]) * multipliers[i];
+      h ^= h >> 29;
+      sig[i] = std::min(sig[i], h);
+    }
+  }
+
+  // Returns the estimated Jaccard similarity of the sets with signatures
+  // 'a' and 'b', which must come from the same minhash.
+  static double similarity(const std::vector<uint64_t>& a,
+                           const std::vector<uint64_t>& b) {
+    assert(a.size() == b.size());
+    if (a.empty()) return 0;
+    size_t equal = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+      equal += (a[i] == b[i]);
+    }
+    return double(equal) / a.size();
+  }
+
+ private:
+  std::vector<uint64_t> offsets_;
+  std::vector<uint64_t> multipliers_;
+  Hash hash_;
+};
+
+// Returns the 64-bit SimHash (Charikar, "Similarity estimation techniques
+// from rounding algorithms") of the tokens in [begin, end): bit i is set if
+// more tokens have bit i of their hash set than clear. Unlike MinHash,
+// repeated tokens count once per occurrence. The Hamming distance between
+// two SimHashes is small when the token streams are similar.
+template <typename InputIterator,
+          typename Hash = std_::hash<
+              typename std::iterator_traits<InputIterator>::value_type>>
+uint64_t simhash(InputIterator begin, InputIterator end,
+                 const Hash& hash = Hash()) {
+  int32_t counts[64] = {};
+  for (; begin != end; ++begin) {
+    const uint64_t h = static_cast<uint64_t>(hash(*begin));
+    // Branch-free, so that the compiler can vectorize it.
+    for (int bit = 0; bit < 64; ++bit) {
+      counts[bit] += int32_t((h >> bit) & 1) * 2 - 1;
+    }
+  }
+  uint64_t result = 0;
+  for (int bit = 0; bit < 64; ++bit) {
+    result |= uint64_t(counts[bit] > 0) << bit;
+  }
+  return result;
+}
+
+inline int hamming_distance(uint64_t a, uint64_t b) {
+  return __builtin_popcountll(a ^ b);
+}
+
+// Finds candidate near-duplicates among MinHash signatures, using the
+// banding technique (Leskovec et al., "Mining of Massive Datasets", 3.4):
+// each signature is split into 'num_bands' bands of 'rows_per_band'
+// values, and two signatures are candidates if they agree on every value
+// of at least one band. Sets with Jaccard similarity s become candidates
+// with probability 1 - (1 - s^rows_per_band)^num_bands, an S-curve with
+// its threshold near (1/num_bands)^(1/rows_per_band).
+//
+// Id must be copyable and less-than comparable.
+template <typename Id>
+class lsh_index {
+ public:
+  lsh_index(size_t num_bands, size_t rows_per_band)
+      : rows_per_band_(rows_per_band), buckets_(num_bands) {
+    assert(num_bands > 0 && rows_per_band > 0);
+  }
+
+  size_t num_bands() const { return buckets_.size(); }
+  size_t rows_per_band() const { return rows_per_band_; }
+
+  // Adds the set with the given signature, which must have at least
+  // num_bands() * rows_per_band() values.
+  void insert(const Id& id, const std::vector<uint64_t>& signature) {
+    for (size_t band = 0; band < buckets_.size(); ++band) {
+      buckets_[band][band_hash(signature, band)].push_back(id);
+    }
+  }
+
+  // Returns the ids of the sets that share at least one band with
+  // 'signature', sorted and without duplicates.
+  std::vector<Id> query(const std::vector<uint64_t>& signature) const {
+    std::vector<Id> candidates;
+    for (size_t band = 0; band < buckets_.size(); ++band) {
+      auto it = buckets_[band].find(band_hash(signature, band));
+      if (it != buckets_[band].end()) {
+        candidates.insert(candidates.end(), it->second.begin(),
+                          it->second.end());
+      }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                     candidates.end());
+    return candidates;
+  }
+
+ private:
+  size_t band_hash(const std::vector<uint64_t>& signature,
+                   size_t band) const {
+    assert(signature.size() >= buckets_.size() * rows_per_band_);
+    const uint64_t* rows = signature.data() + band * rows_per_band_;
+    farmhash::state_type state;
+    return farmhash::result_type(
+        hash_combine_range(farmhash(&state), rows, rows + rows_per_band_));
+  }
+
+  size_t rows_per_band_;
+  // One table per band, keyed by the band's farmhash. The keys are already
+  // well-mixed hashes, so std::hash (the identity in common implementations)
+  // suffices.
+  std::vector<std::unordered_map<size_t, std::vector<Id>>> buckets_;
+};
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_SIMILARITY_H
@@ -0,0 +1,83 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "similarity.h"
+
+namespace {
+
+std::vector<std::string> Words(int first, int last) {
+  std::vector<std::string> words;
+  for (int i = first; i < last; ++i) {
+    words.push_back("word" + std::to_string(i));
+  }
+  return words;
+}
+
+TEST(MinHashTest, IgnoresOrderAndRepetition) {
+  hashing::minhash<std::string> mh;
+  std::vector<std::string> a = Words(0, 100);
+  std::vector<std::string> b(a.rbegin(), a.rend());
+  b.insert(b.end(), a.begin(), a.begin() + 10);
+  EXPECT_EQ(mh.signature(a), mh.signature(b));
+  EXPECT_EQ(1.0, mh.similarity(mh.signature(a), mh.signature(b)));
+}
+
+TEST(MinHashTest, EstimatesJaccardSimilarity) {
+  hashing::minhash<std::string> mh(512);
+  // |A & B| = 500 and |A | B| = 1500.
+  const auto a = mh.signature(Words(0, 1000));
+  const auto b = mh.signature(Words(500, 1500));
+  EXPECT_NEAR(1.0 / 3, mh.similarity(a, b), 0.07);
+  const auto c = mh.signature(Words(2000, 3000));
+  EXPECT_NEAR(0.0, mh.similarity(a, c), 0.02);
+}
+
+TEST(MinHashTest, SeedChangesFunctions) {
+  hashing::minhash<int> mh1(64, 1), mh2(64, 2);
+  const std::vector<int> tokens = {1, 2, 3};
+  EXPECT_NE(mh1.signature(tokens), mh2.signature(tokens));
+}
+
+TEST(SimHashTest, SimilarStreamsAreClose) {
+  const std::vector<std::string> a = Words(0, 1000);
+  std::vector<std::string> b = a;
+  for (int i = 0; i < 20; ++i) b[i * 50] = "changed" + std::to_string(i);
+  const std::vector<std::string> c = Words(1000, 2000);
+
+  const uint64_t ha = hashing::simhash(a.begin(), a.end());
+  const uint64_t hb = hashing::simhash(b.begin(), b.end());
+  const uint64_t hc = hashing::simhash(c.begin(), c.end());
+  EXPECT_LT(hashing::hamming_distance(ha, hb), 12);
+  EXPECT_GT(hashing::hamming_distance(ha, hc), 16);
+}
+
+TEST(LshIndexTest, FindsNearDuplicates) {
+  hashing::minhash<std::string> mh(128);
+  hashing::lsh_index<int> index(32, 4);
+  for (int doc = 0; doc < 100; ++doc) {
+    index.insert(doc, mh.signature(Words(doc * 1000, doc * 1000 + 200)));
+  }
+  // Jaccard similarity 190 / 210 with document 7, and 0 with the others.
+  const auto query = mh.signature(Words(7010, 7210));
+  EXPECT_EQ(std::vector<int>{7}, index.query(query));
+  EXPECT_TRUE(index.query(mh.signature(Words(500000, 500200))).empty());
+}
+
+}  // namespace
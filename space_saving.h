@@ -0,0 +1,211 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Space-Saving heavy-hitters summary (Metwally et al., "Efficient
+// Computation of Frequent and Top-k Elements in Data Streams") for any type
+// that std_::hash supports. Not part of this proposal.
+
+#ifndef HASHING_DEMO_SPACE_SAVING_H
+#define HASHING_DEMO_SPACE_SAVING_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "std.h"
+
+namespace hashing {
+
+// Tracks the approximate top-k most frequent keys of a stream, using
+// O(capacity) memory. Any key whose true count exceeds
+// total_count() / capacity() is guaranteed to be tracked. For each tracked
+// key, count is an overestimate of its true count by at most error.
+template <typename T, typename Hash = std_::hash<T>,
+          typename KeyEqual = std::equal_to<T>>
+class space_saving {
+ public:
+  struct entry {
+    T key;
+    uint64_t count;
+    uint64_t error;
+  };
+
+  explicit space_saving(size_t capacity, Hash hash = Hash(),
+                        KeyEqual equal = KeyEqual())
+      : capacity_(capacity), index_(capacity, std::move(hash),
+                                    std::move(equal)) {
+    assert(capacity > 0);
+    entries_.reserve(capacity);
+    heap_.reserve(capacity);
+  }
+
+  void add(const T& key, uint64_t count = 1) {
+    total_count_ += count;
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      entries_[it->second].count += count;
+      sift_down(heap_position_[it->second]);
+      return;
+    }
+    if (entries_.size() < capacity_) {
+      const size_t e = entries_.size();
+      entries_.push_back(entry{key, count, 0});
+      index_.emplace(key, e);
+      heap_.push_back(e);
+      heap_position_.push_back(heap_.size() - 1);
+      sift_up(heap_.size() - 1);
+      return;
+    }
+    // Replace the entry with the smallest count, and charge its count to
+    // the new key as potential error. The evicted key's map node is reused,
+    // to avoid an allocation on every miss once the summary is full.
+    const size_t e = heap_[0];
+    auto node = index_.extract(entries_[e].key);
+    node.key() = key;
+    index_.insert(std::move(node));
+    const uint64_t min_count = entries_[e].count;
+    entries_[e] = entry{key, min_count + count, min_count};
+    sift_down(0);
+  }
+
+  // Returns the tracked entries with the highest counts, in decreasing
+  // order of count. There are at most min(k, capacity()) of them.
+  std::vector<entry> top(size_t k) const {
+    std::vector<entry> result(entries_);
+    k = std::min(k, result.size());
+    std::partial_sort(result.begin(), result.begin() + k, result.end(),
+                      [](const entry& a, const entry& b) {
+                        return a.count > b.count;
+                      });
+    result.resize(k);
+    return result;
+  }
+
+  // Combines the summary of 'other' into this one, following Agarwal et
+  // al., "Mergeable Summaries". A key missing from a full summary may have
+  // occurred up to that summary's minimum count times, so it is charged
+  // that count as error.
+  void merge(const space_saving& other) {
+    const uint64_t this_min = min_count();
+    const uint64_t other_min = other.min_count();
+    std::vector<entry> combined;
+    combined.reserve(entries_.size() + other.entries_.size());
+    for (const entry& e : entries_) {
+      auto it = other.index_.find(e.key);
+      if (it == other.index_.end()) {
+        combined.push_back(
+            entry{e.key, e.count + other_min, e.error + other_min});
+      } else {
+        const entry& o = other.entries_[it->second];
+        combined.push_back(
+            entry{e.key, e.count + o.count, e.error + o.error});
+      }
+    }
+    for (const entry& o : other.entries_) {
+      if (index_.find(o.key) == index_.end()) {
+        combined.push_back(
+            entry{o.key, o.count + this_min, o.error + this_min});
+      }
+    }
+    const size_t k = std::min(capacity_, combined.size());
+    std::partial_sort(combined.begin(), combined.begin() + k, combined.end(),
+                      [](const entry& a, const entry& b) {
+                        return a.count > b.count;
+                      });
+    combined.resize(k);
+
+    const uint64_t total_count = total_count_ + other.total_count_;
+    clear();
+    total_count_ = total_count;
+    for (entry& e : combined) {
+      index_.emplace(e.key, entries_.size());
+      heap_.push_back(entries_.size());
+      heap_position_.push_back(heap_.size() - 1);
+      entries_.push_back(std::move(e));
+    }
+    for (size_t i = heap_.size() / 2; i-- > 0;) {
+      sift_down(i);
+    }
+  }
+
+  void clear() {
+    entries_.clear();
+    heap_.clear();
+    heap_position_.clear();
+    index_.clear();
+    total_count_ = 0;
+  }
+
+  size_t size() const { return entries_.size(); }
+  size_t capacity() const { return capacity_; }
+  uint64_t total_count() const { return total_count_; }
+
+ private:
+  // Returns the count below which untracked keys may lie: 0 while the
+  // summary has room, and the smallest tracked count once it is full.
+  uint64_t min_count() const {
+    return entries_.size() < capacity_ ? 0 : entries_[heap_[0]].count;
+  }
+
+  uint64_t count_at(size_t heap_index) const {
+    return entries_[heap_[heap_index]].count;
+  }
+
+  void swap_heap(size_t a, size_t b) {
+    std::swap(heap_[a], heap_[b]);
+    heap_position_[heap_[a]] = a;
+    heap_position_[heap_[b]] = b;
+  }
+
+  void sift_up(size_t i) {
+    while (i > 0 && count_at(i) < count_at((i - 1) / 2)) {
+      swap_heap(i, (i - 1) / 2);
+      i = (i - 1) / 2;
+    }
+  }
+
+  void sift_down(size_t i) {
+    for (;;) {
+      size_t smallest = i;
+      for (size_t child = 2 * i + 1; child <= 2 * i + 2; ++child) {
+        if (child < heap_.size() && count_at(child) < count_at(smallest)) {
+          smallest = child;
+        }
+      }
+      if (smallest == i) return;
+      swap_heap(i, smallest);
+      i = smallest;
+    }
+  }
+
+  size_t capacity_;
+  uint64_t total_count_ = 0;
+
+  // entries_ holds the tracked keys, index_ maps each key to its position
+  // in entries_, and heap_ is a min-heap of positions in entries_, ordered
+  // by count. heap_position_ is the inverse of heap_.
+  std::vector<entry> entries_;
+  std::unordered_map<T, size_t, Hash, KeyEqual> index_;
+  std::vector<size_t> heap_;
+  std::vector<size_t> heap_position_;
+};
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_SPACE_SAVING_H
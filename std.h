@@ -58,6 +58,104 @@ struct hash {
   }
 };
 
+// Hashing strategy introspection
+// ==========================================================================
+// hashing_strategy<T, HashCode>::value tells how hash_combine(HashCode, T)
+// will process a T, following the same traits as simple_hash_combine():
+//
+// - contiguous_bytes: T is uniquely represented, so its object
+//   representation is hashed in a single hash_combine_range() call.
+// - per_field: T's hash_value() is called, which typically hashes each of
+//   its fields separately.
+// - type_erased: T's hash_value() is out of line, and will see HashCode
+//   only through type_erased_hash_code (see is_hashed_via_type_erasure).
+// - unsupported: there is no hash_value() for T and HashCode.
+//
+// range_hashing_strategy<InputIterator, HashCode>::value is either
+// contiguous_bytes, if hash_combine_range() hashes [begin, end) as a single
+// byte range, or per_element.
+//
+// This reflects the generic HashCodes; one that hashes some types
+// specially, such as type_invariant_farmhash, may differ. Since hash_value()
+// overloads for containers are unconstrained, a container of an unhashable
+// type is reported as per_field, not unsupported.
+enum class hash_strategy {
+  contiguous_bytes,
+  per_field,
+  per_element,
+  type_erased,
+  unsupported,
+};
+
+namespace detail {
+template <typename T, typename HashCode, typename = void>
+struct supports_hash_value_with : public false_type {};
+
+template <typename T, typename HashCode>
+struct supports_hash_value_with<
+    T, HashCode,
+    void_t<decltype(hash_value(declval<HashCode>(), declval<const T&>()))>>
+    : public true_type {};
+
+template <typename T, typename HashCode>
+constexpr hash_strategy get_hashing_strategy() {
+  if (is_uniquely_represented<T>::value) {
+    return hash_strategy::contiguous_bytes;
+  } else if (!supports_hash_value_with<T, HashCode>::value) {
+    return hash_strategy::unsupported;
+  } else if (is_hashed_via_type_erasure<T, HashCode>::value) {
+    return hash_strategy::type_erased;
+  } else {
+    return hash_strategy::per_field;
+  }
+}
+}  // namespace detail
+
+template <typename T, typename HashCode = hash_code>
+struct hashing_strategy
+    : public integral_constant<
+          hash_strategy, detail::get_hashing_strategy<T, HashCode>()> {};
+
+template <typename InputIterator, typename HashCode = hash_code>
+struct range_hashing_strategy
+    : public integral_constant<
+          hash_strategy,
+          detail::can_hash_range_as_bytes<InputIterator>::value
+              ? hash_strategy::contiguous_bytes
+              : hash_strategy::per_element> {};
+
+namespace detail {
+// Instantiated only to check a hashing strategy; if the check fails, the
+// compiler's error message shows the Actual strategy.
+template <typename T, hash_strategy Expected, hash_strategy Actual>
+struct check_hashing_strategy {
+  static_assert(Expected == Actual,
+                "T is not hashed with the expected strategy");
+  static constexpr bool value = Expected == Actual;
+};
+}  // namespace detail
+
+// Returns true if T is hashed with strategy Expected, and otherwise fails to
+// compile with a message naming the actual strategy, for example:
+//
+//   static_assert(std_::expect_hashing_strategy<
+//                     Key, std_::hash_strategy::contiguous_bytes>(), "");
+template <typename T, hash_strategy Expected, typename HashCode = hash_code>
+constexpr bool expect_hashing_strategy() {
+  return detail::check_hashing_strategy<
+      T, Expected, hashing_strategy<T, HashCode>::value>::value;
+}
+
+// Like expect_hashing_strategy(), for the range [InputIterator,
+// InputIterator).
+template <typename InputIterator, hash_strategy Expected,
+          typename HashCode = hash_code>
+constexpr bool expect_range_hashing_strategy() {
+  return detail::check_hashing_strategy<
+      InputIterator, Expected,
+      range_hashing_strategy<InputIterator, HashCode>::value>::value;
+}
+
 // std_::unordered set uses std_::hash by default. The other unordered
 // containers could be aliased similarly.
 template <typename Key,
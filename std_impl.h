@@ -21,8 +21,12 @@
 
 #include <cstddef>
 #include <forward_list>
+#include <iterator>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace std_ {
@@ -126,6 +130,16 @@ struct is_uniquely_represented<array<T, N>>
     : public integral_constant<bool, is_uniquely_represented<T>::value &&
                                sizeof(T[N]) == sizeof(array<T, N>)> {};
 
+// is_hashed_via_type_erasure type trait
+// ==========================================================================
+// Specialized to true for types whose hash_value() is compiled out of line,
+// and so reaches HashCode only through hashing::type_erased_hash_code (see
+// type_erased_hash_code.h). It can't be detected automatically, since the
+// out-of-line hash_value() is an ordinary template as far as callers can
+// tell. Used only by hashing_strategy in std.h.
+template <typename T, typename HashCode, typename Enable = void>
+struct is_hashed_via_type_erasure : false_type {};
+
 // hash_value function overloads for standard types
 // ==========================================================================
 
@@ -151,6 +165,57 @@ HashCode hash_sized_container(
       // hash value.
       static_cast<size_t>(container.size()));
 }
+
+// Hashes one element of an unordered container on its own, for
+// unordered_hash_sum(), with a fresh HashCode of the same type as 'code',
+// the HashCode that the container is being hashed with, so that every
+// HashCode sees the elements. This works for HashCodes that are
+// default-constructible, or constructed from a pointer to a state_type
+// like farmhash; other HashCodes must specialize it.
+template <typename HashCode, typename = void>
+struct unordered_element_hasher {
+  template <typename T>
+  static size_t hash(const HashCode& /*code*/, const T& value) {
+    return static_cast<size_t>(
+        typename HashCode::result_type(hash_combine(HashCode(), value)));
+  }
+};
+
+template <typename HashCode>
+struct unordered_element_hasher<HashCode,
+                                std::void_t<typename HashCode::state_type>> {
+  template <typename T>
+  static size_t hash(const HashCode& /*code*/, const T& value) {
+    typename HashCode::state_type state;
+    return static_cast<size_t>(typename HashCode::result_type(
+        hash_combine(HashCode(&state), value)));
+  }
+};
+
+// Returns the sum (mod 2^64) of the hashes of the elements of 'container',
+// each computed by unordered_element_hasher. For std_::hash_code, each
+// element's hash is its std_::hash.
+template <typename HashCode, typename Container>
+size_t unordered_hash_sum(const HashCode& code, const Container& container) {
+  size_t sum = 0;
+  for (const auto& value : container) {
+    sum += unordered_element_hasher<HashCode>::hash(code, value);
+  }
+  return sum;
+}
+
+// Requires: Container has begin(), end(), and size() methods
+// Unordered containers don't have a well-defined iteration order, so we
+// hash each element on its own, and combine the element hashes with a
+// commutative operation. Addition (unlike XOR) doesn't cancel out
+// duplicates, so this also works for multisets.
+template <typename HashCode, typename Container>
+HashCode hash_unordered_container(
+    HashCode code, const Container& container) {
+  const size_t sum = unordered_hash_sum(code, container);
+  return hash_combine(std::move(code), sum,
+                      static_cast<size_t>(container.size()));
+}
 }  // namespace detail
 
 namespace hash_value_detail {
@@ -181,7 +246,7 @@ HashCode hash_value(HashCode code, T* ptr) {
 
 template <typename HashCode>
 HashCode hash_value(HashCode code, nullptr_t p) {
-  return hash_combine(code, static_cast<unsigned char>(0));
+  return hash_combine(std::move(code), static_cast<unsigned char>(0));
 }
 
 template <typename HashCode, typename T>
@@ -195,9 +260,8 @@ HashCode hash_value(HashCode code, const string& s) {
 }
 
 // TODO: similar overloads for deque, list, set, map, multiset, multimap.
-// Unordered containers are omitted as discussed in N3980. C-style arrays
-// are omitted because they seem unlikely to be useful, and it's not entirely
-// clear whether the size should be hashed.
+// C-style arrays are omitted because they seem unlikely to be useful, and
+// it's not entirely clear whether the size should be hashed.
 
 // I've chosen to treat std::array as a container rather than a
 // tuple-like type, meaning that the hash includes the size.
@@ -220,6 +284,34 @@ HashCode hash_value(HashCode code, const forward_list<T>& l) {
   return hash_combine(std::move(code), size);
 }
 
+// N3980 omits unordered containers, because two equal containers can
+// iterate in different orders. We instead use an order-independent hash
+// representation; see detail::hash_unordered_container.
+template <typename HashCode, typename K, typename H, typename E, typename A>
+HashCode hash_value(HashCode code, const std::unordered_set<K, H, E, A>& s) {
+  return detail::hash_unordered_container(std::move(code), s);
+}
+
+template <typename HashCode, typename K, typename H, typename E, typename A>
+HashCode hash_value(HashCode code,
+                    const std::unordered_multiset<K, H, E, A>& s) {
+  return detail::hash_unordered_container(std::move(code), s);
+}
+
+template <typename HashCode, typename K, typename V, typename H, typename E,
+          typename A>
+HashCode hash_value(HashCode code,
+                    const std::unordered_map<K, V, H, E, A>& m) {
+  return detail::hash_unordered_container(std::move(code), m);
+}
+
+template <typename HashCode, typename K, typename V, typename H, typename E,
+          typename A>
+HashCode hash_value(HashCode code,
+                    const std::unordered_multimap<K, V, H, E, A>& m) {
+  return detail::hash_unordered_container(std::move(code), m);
+}
+
 template <typename HashCode, typename T, typename D>
 HashCode hash_value(HashCode code, const unique_ptr<T,D>& ptr) {
   return hash_combine(std::move(code), ptr.get());
@@ -273,8 +365,32 @@ template <typename T>
 // of this proposal, but they synergize well.
 // ==========================================================================
 
+namespace detail {
+// vector<T>::iterator is typically a class type from which T can't be
+// deduced, so we recognize it by comparing it with the iterator types of
+// vector<value_type>. vector<bool> is excluded, since it's not contiguous.
+template <typename Iterator, typename = void>
+struct is_vector_iterator : public false_type {};
+
+template <typename Iterator>
+struct is_vector_iterator<
+    Iterator,
+    enable_if_t<!std::is_pointer<Iterator>::value &&
+                !std::is_same<typename std::iterator_traits<
+                                  Iterator>::value_type,
+                              bool>::value>>
+    : public integral_constant<
+          bool,
+          std::is_same<Iterator, typename vector<typename std::iterator_traits<
+                                     Iterator>::value_type>::iterator>::value ||
+              std::is_same<Iterator,
+                           typename vector<typename std::iterator_traits<
+                               Iterator>::value_type>::const_iterator>::value> {
+};
+}  // namespace detail
+
 template <typename T>
-struct is_contiguous_iterator : public false_type {};
+struct is_contiguous_iterator : public detail::is_vector_iterator<T> {};
 
 template <typename T>
 struct is_contiguous_iterator<T*> : public true_type {};
@@ -293,6 +409,31 @@ struct is_contiguous_iterator<string::const_iterator>
 
 inline const char* adl_pointer_from(string::const_iterator i) { return &*i; }
 
+template <typename Iterator>
+enable_if_t<detail::is_vector_iterator<Iterator>::value,
+            typename std::iterator_traits<Iterator>::pointer>
+adl_pointer_from(Iterator i) {
+  return std::addressof(*i);
+}
+
+namespace detail {
+
+// Returns pointers to the first element of the contiguous range
+// [begin, end) and one past its last element. 'end' is never dereferenced,
+// and neither is 'begin' if the range is empty, in which case both
+// pointers are null.
+template <typename ContiguousIterator>
+auto contiguous_range_pointers(ContiguousIterator begin,
+                               ContiguousIterator end) {
+  using std_::adl_pointer_from;
+  using pointer = decltype(adl_pointer_from(begin));
+  if (begin == end) return std::pair<pointer, pointer>(nullptr, nullptr);
+  const pointer first = adl_pointer_from(begin);
+  return std::pair<pointer, pointer>(first, first + (end - begin));
+}
+
+}  // namespace detail
+
 // Convenience helper functions for implementing hash algorithms
 // ==========================================================================
 
@@ -340,11 +481,11 @@ struct can_hash_range_as_bytes
 template <typename HashCode, typename InputIterator>
 HashCode hash_range_or_bytes(HashCode hash_code, InputIterator begin,
                              InputIterator end, const std::true_type&) {
-  using std_::adl_pointer_from;
+  const auto pointers = contiguous_range_pointers(begin, end);
   const unsigned char* begin_ptr =
-      reinterpret_cast<const unsigned char*>(adl_pointer_from(begin));
+      reinterpret_cast<const unsigned char*>(pointers.first);
   const unsigned char* end_ptr =
-      reinterpret_cast<const unsigned char*>(adl_pointer_from(end));
+      reinterpret_cast<const unsigned char*>(pointers.second);
   return hash_combine_range(std::move(hash_code), begin_ptr, end_ptr);
 }
 
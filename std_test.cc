@@ -14,11 +14,18 @@
 
 #include <cassert>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "gtest/gtest.h"
 
+#include "cached_hash.h"
 #include "debug.h"
+#include "fnv1a.h"
+#include "parallel_hash.h"
 #include "std.h"
+#include "type_invariant_farmhash.h"
 
 struct Hashable {
   int i;
@@ -154,7 +161,161 @@ struct is_uniquely_represented<UniquelyRepresented> : true_type {};
 
 }  // namespace std_
 
+using std_::hash_strategy;
+using std_::hashing_strategy;
+using std_::range_hashing_strategy;
+
+static_assert(hashing_strategy<int>::value == hash_strategy::contiguous_bytes,
+              "");
+static_assert(hashing_strategy<std::pair<int, int>>::value ==
+                  hash_strategy::contiguous_bytes,
+              "");
+static_assert(hashing_strategy<UniquelyRepresented>::value ==
+                  hash_strategy::contiguous_bytes,
+              "");
+// Padding between the members
+static_assert(hashing_strategy<std::pair<char, int>>::value ==
+                  hash_strategy::per_field,
+              "");
+static_assert(hashing_strategy<std::string>::value == hash_strategy::per_field,
+              "");
+static_assert(hashing_strategy<Hashable>::value == hash_strategy::per_field,
+              "");
+static_assert(hashing_strategy<NotHashable>::value ==
+                  hash_strategy::unsupported,
+              "");
+// Hashable's hash_value() only accepts std_::hash_code.
+static_assert(hashing_strategy<Hashable, hashing::identity>::value ==
+                  hash_strategy::unsupported,
+              "");
+
+static_assert(range_hashing_strategy<const int*>::value ==
+                  hash_strategy::contiguous_bytes,
+              "");
+static_assert(range_hashing_strategy<std::vector<int>::const_iterator>::value ==
+                  hash_strategy::contiguous_bytes,
+              "");
+static_assert(
+    range_hashing_strategy<std::vector<std::string>::const_iterator>::value ==
+        hash_strategy::per_element,
+    "");
+static_assert(
+    range_hashing_strategy<std::unordered_set<int>::const_iterator>::value ==
+        hash_strategy::per_element,
+    "");
+
+static_assert(std_::expect_hashing_strategy<
+                  std::tuple<int, int>, hash_strategy::contiguous_bytes>(),
+              "");
+static_assert(std_::expect_range_hashing_strategy<
+                  std::string::const_iterator,
+                  hash_strategy::contiguous_bytes>(),
+              "");
+
 TEST(StdTest, AppliesUniquelyRepresentedOptimization) {
   EXPECT_EQ(std_::hash<UniquelyRepresented>{}(UniquelyRepresented{42}),
             std_::hash<int>{}(42));
 }
+
+TEST(StdTest, CachedHashMatchesUncachedHash) {
+  const std::string s(100, 'x');
+  auto cached = hashing::make_cached_hash(s);
+  EXPECT_EQ(std_::hash<std::string>{}(s), cached.hash());
+  EXPECT_EQ(std_::hash<std::string>{}(s),
+            std_::hash<hashing::cached_hash<std::string>>{}(cached));
+  EXPECT_EQ(s, cached.value());
+}
+
+TEST(StdTest, CachedHashEquality) {
+  auto a = hashing::make_cached_hash(std::string("foo"));
+  auto b = hashing::make_cached_hash(std::string("foo"));
+  auto c = hashing::make_cached_hash(std::string("bar"));
+  EXPECT_TRUE(a == b);
+  EXPECT_FALSE(a != b);
+  EXPECT_FALSE(a == c);
+  EXPECT_TRUE(a != c);
+}
+
+TEST(StdTest, CachedHashInUnorderedSet) {
+  std_::unordered_set<hashing::cached_hash<std::string>> set;
+  for (int i = 0; i < 100; ++i) {
+    set.insert(hashing::make_cached_hash(std::to_string(i)));
+  }
+  set.rehash(1000);
+  EXPECT_EQ(100u, set.size());
+  EXPECT_TRUE(set.find(hashing::make_cached_hash(std::string("42"))) !=
+              set.end());
+  EXPECT_TRUE(set.find(hashing::make_cached_hash(std::string("100"))) ==
+              set.end());
+}
+
+TEST(StdTest, UnorderedContainerHashIsOrderIndependent) {
+  std::unordered_set<int> a, b;
+  for (int i = 0; i < 1000; ++i) {
+    a.insert(i);
+    b.insert(999 - i);
+  }
+  b.rehash(10000);
+  ASSERT_NE(*a.begin(), *b.begin()) << "Bug in test: same iteration order";
+  EXPECT_EQ(std_::hash<std::unordered_set<int>>{}(a),
+            std_::hash<std::unordered_set<int>>{}(b));
+
+  b.erase(500);
+  EXPECT_NE(std_::hash<std::unordered_set<int>>{}(a),
+            std_::hash<std::unordered_set<int>>{}(b));
+}
+
+TEST(StdTest, UnorderedMultisetHashCountsDuplicates) {
+  std::unordered_multiset<std::string> once = {"a", "b"};
+  std::unordered_multiset<std::string> twice = {"a", "a", "b", "b"};
+  std::unordered_multiset<std::string> twice_reordered = {"b", "a", "b", "a"};
+  using Hash = std_::hash<std::unordered_multiset<std::string>>;
+  EXPECT_NE(Hash{}(once), Hash{}(twice));
+  EXPECT_EQ(Hash{}(twice), Hash{}(twice_reordered));
+}
+
+TEST(StdTest, UnorderedMapHashCoversValues) {
+  std::unordered_map<std::string, int> a = {{"x", 1}, {"y", 2}};
+  std::unordered_map<std::string, int> b = {{"y", 2}, {"x", 1}};
+  std::unordered_map<std::string, int> c = {{"x", 2}, {"y", 1}};
+  using Hash = std_::hash<std::unordered_map<std::string, int>>;
+  EXPECT_EQ(Hash{}(a), Hash{}(b));
+  EXPECT_NE(Hash{}(a), Hash{}(c));
+}
+
+TEST(StdTest, ParallelUnorderedHashMatchesSequential) {
+  std_::unordered_set<std::string> set;
+  for (int i = 0; i < 10000; ++i) {
+    set.insert(std::to_string(i));
+  }
+  const size_t expected = std_::hash<decltype(set)>{}(set);
+  for (unsigned threads : {1u, 2u, 3u, 8u}) {
+    EXPECT_EQ(expected, hashing::parallel_unordered_hash(set, threads))
+        << threads;
+  }
+  EXPECT_EQ(std_::hash<decltype(set)>{}(decltype(set){}),
+            hashing::parallel_unordered_hash(decltype(set){}, 4));
+}
+
+// std_debug_test runs this with _GLIBCXX_DEBUG, which aborts if a hash
+// dereferences a vector's end(), or the begin() of an empty vector.
+TEST(StdTest, VectorBytesAreHashedWithoutDereferencingEnd) {
+  const std::vector<int> empty;
+  const std::vector<int> values{1, 2, 3};
+  const std::vector<int> copy = values;
+
+  using Hash = std_::hash<std::vector<int>>;
+  EXPECT_EQ(Hash{}(values), Hash{}(copy));
+  EXPECT_NE(Hash{}(empty), Hash{}(values));
+
+  EXPECT_EQ(size_t(hash_combine(hashing::fnv1a(), values)),
+            size_t(hash_combine(hashing::fnv1a(), copy)));
+  EXPECT_NE(size_t(hash_combine(hashing::fnv1a(), empty)),
+            size_t(hash_combine(hashing::fnv1a(), values)));
+
+  const hashing::type_invariant_hash invariant_hash;
+  EXPECT_EQ(invariant_hash(values),
+            invariant_hash(std::vector<int64_t>{1, 2, 3}));
+  EXPECT_EQ(invariant_hash(empty), invariant_hash(std::vector<int64_t>{}));
+  EXPECT_NE(invariant_hash(empty), invariant_hash(values));
+}
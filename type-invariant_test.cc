@@ -12,11 +12,15 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstdint>
 #include <set>
+#include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "fnv1a.h"
 #include "gtest/gtest.h"
+#include "type_invariant_farmhash.h"
 
 // String class that uses string interning to represent the contents.
 // This makes things like hashing and comparison extremely efficient.
@@ -45,6 +49,11 @@ class InternedString {
       hashing::type_invariant_fnv1a hash_code, InternedString i) {
     return hash_combine(std::move(hash_code), *i.str_);
   }
+
+  friend hashing::type_invariant_farmhash hash_value(
+      hashing::type_invariant_farmhash hash_code, InternedString i) {
+    return hash_combine(std::move(hash_code), *i.str_);
+  }
 };
 
 std::set<std::string> InternedString::intern_pool_{};
@@ -67,3 +76,66 @@ TEST(TypeInvariantTest, TestTypeInvariance) {
   EXPECT_EQ(size_t(hash_value(hashing::type_invariant_fnv1a{}, interned)),
             size_t(hash_value(hashing::type_invariant_fnv1a{}, ordinary)));
 }
+
+TEST(TypeInvariantTest, FarmhashIsTypeInvariantForStrings) {
+  std::vector<InternedString> interned = {"a", "b", "c"};
+  std::vector<std::string> ordinary = {"a", "b", "c"};
+
+  hashing::type_invariant_hash hash;
+  EXPECT_EQ(hash(interned), hash(ordinary));
+  EXPECT_EQ(hash(InternedString("abc")), hash(std::string("abc")));
+  EXPECT_NE(hash(std::string("abc")), hash(std::string("abd")));
+}
+
+TEST(TypeInvariantTest, FarmhashIsTypeInvariantForNumbers) {
+  hashing::type_invariant_hash hash;
+  EXPECT_EQ(hash(5), hash(5L));
+  EXPECT_EQ(hash(5), hash(5u));
+  EXPECT_EQ(hash(int16_t{-5}), hash(int64_t{-5}));
+  EXPECT_EQ(hash(int8_t{5}), hash(5));
+  EXPECT_EQ(hash(uint8_t{5}), hash(int16_t{5}));
+  EXPECT_EQ(hash(int8_t{-5}), hash(int64_t{-5}));
+  EXPECT_EQ(hash(uint8_t{200}), hash(200u));
+  EXPECT_NE(hash(5), hash(6L));
+  EXPECT_EQ(hash(1.5f), hash(1.5));
+  EXPECT_EQ(hash(0.0), hash(-0.0));
+
+  const std::vector<int> ints = {1, -2, 3, 1 << 30};
+  const std::vector<long> longs(ints.begin(), ints.end());
+  const std::vector<int64_t> int64s(ints.begin(), ints.end());
+  EXPECT_EQ(hash(ints), hash(longs));
+  EXPECT_EQ(hash(ints), hash(int64s));
+
+  // Exercise the blocked widening of long ranges.
+  std::vector<int16_t> shorts(1000);
+  for (size_t i = 0; i < shorts.size(); ++i) shorts[i] = int16_t(i * 7);
+  const std::vector<int64_t> wide(shorts.begin(), shorts.end());
+  EXPECT_EQ(hash(shorts), hash(wide));
+
+  const std::vector<int8_t> int8s = {1, -2, 3, 127};
+  const std::vector<uint8_t> uint8s = {1, 2, 3, 255};
+  EXPECT_EQ(hash(int8s), hash(std::vector<int64_t>(int8s.begin(),
+                                                   int8s.end())));
+  EXPECT_EQ(hash(uint8s), hash(std::vector<int>(uint8s.begin(),
+                                                uint8s.end())));
+}
+
+TEST(TypeInvariantTest, FarmhashSupportsHeterogeneousLookup) {
+  std::set<long> keys = {1, 2, 3};
+  std::set<size_t> hashes;
+  hashing::type_invariant_hash hash;
+  for (long key : keys) hashes.insert(hash(key));
+  EXPECT_EQ(1u, hashes.count(hash(2)));
+  EXPECT_EQ(0u, hashes.count(hash(4)));
+}
+
+// This file includes only std_impl.h, not std.h, so this also checks that
+// unordered containers can be hashed without it.
+TEST(TypeInvariantTest, UnorderedContainersHashElementsWithTheSameHashCode) {
+  auto fnv1a = [](const auto&... values) {
+    return size_t(hash_combine(hashing::fnv1a(), values...));
+  };
+  const std::unordered_set<int> set = {1, 2, 3};
+  EXPECT_EQ(fnv1a(fnv1a(1) + fnv1a(2) + fnv1a(3), size_t{3}), fnv1a(set));
+  EXPECT_EQ(fnv1a(set), fnv1a(std::unordered_set<int>{3, 2, 1}));
+}
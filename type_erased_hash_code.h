@@ -15,37 +15,152 @@
 #ifndef HASHING_DEMO_TYPE_ERASED_HASH_CODE_H
 #define HASHING_DEMO_TYPE_ERASED_HASH_CODE_H
 
-#include <functional>
-#include <memory>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
 #include <utility>
 
 #include "std.h"
 
 namespace hashing {
 
+// A HashCode that forwards byte ranges to a HashCode of any type, so that
+// hash_value() can be defined out of line, as in pimpl.h.
+//
+// A type_erased_hash_code is a non-owning reference to the wrapped
+// HashCode, through a pointer to it and a pointer to a function that knows
+// its type, so it's trivially copyable and never allocates. Constructed
+// from a pointer to the HashCode, it forwards each byte range with an
+// indirect call. Since hash_value() implementations typically combine many
+// small values, it can instead be constructed from a
+// type_erased_hash_code::buffer, which collects them and forwards them in
+// bulk, costing one indirect call per kBufferSize bytes instead of one per
+// value. Byte ranges may be split or joined freely without changing a
+// HashCode's result, so this doesn't affect the final hash value.
 class type_erased_hash_code {
-  std::function<void(unsigned char const*, unsigned char const*)> wrapper_;
+  using combine_fn = void (*)(void* hash_code, unsigned char const* begin,
+                              unsigned char const* end);
 
   template <typename HashCode>
-  struct HashCodeWrapper {
-    HashCode* hash_code_;
+  static void combine(void* hash_code, unsigned char const* begin,
+                      unsigned char const* end) {
+    HashCode* typed = static_cast<HashCode*>(hash_code);
+    *typed = hash_combine_range(std::move(*typed), begin, end);
+  }
+
+ public:
+  static constexpr size_t kBufferSize = 128;
+
+  // Buffers the bytes for a wrapped HashCode. The bytes are forwarded by
+  // flush(), or at the latest when the buffer is destroyed, so the wrapped
+  // HashCode mustn't be used again until then.
+  class buffer {
+   public:
+    template <typename HashCode>
+    explicit buffer(HashCode* hash_code)
+        : hash_code_(hash_code), combine_(&combine<HashCode>) {}
+
+    buffer(const buffer&) = delete;
+    buffer& operator=(const buffer&) = delete;
+
+    ~buffer() { flush(); }
+
+    // Forwards any buffered bytes to the wrapped HashCode.
+    void flush() {
+      if (size_ != 0) {
+        combine_(hash_code_, bytes_, bytes_ + size_);
+        size_ = 0;
+      }
+    }
 
-    void operator()(unsigned char const* begin, unsigned char const* end) {
-      *hash_code_ = hash_combine_range(std::move(*hash_code_), begin, end);
+    // Mixes [begin, end) into the wrapped HashCode, possibly later.
+    void append(unsigned char const* begin, unsigned char const* end) {
+      const size_t n = end - begin;
+      if (n > kBufferSize - size_) {
+        flush();
+        if (n >= kBufferSize) {
+          combine_(hash_code_, begin, end);
+          return;
+        }
+      }
+      std::memcpy(bytes_ + size_, begin, n);
+      size_ += n;
     }
+
+   private:
+    void* hash_code_;
+    combine_fn combine_;
+    size_t size_ = 0;
+    unsigned char bytes_[kBufferSize];
   };
 
- public:
-  template <typename HashCode>
+  // Forwards each byte range to *hash_code as it's combined.
+  template <typename HashCode,
+            typename = std::enable_if_t<!std::is_same<HashCode, buffer>::value>>
   type_erased_hash_code(HashCode* hash_code)
-      : wrapper_(HashCodeWrapper<HashCode>{hash_code}) {}
+      : hash_code_(hash_code), combine_(&combine<HashCode>) {}
+
+  // Forwards byte ranges to the HashCode wrapped by *buf, in bulk.
+  explicit type_erased_hash_code(buffer* buf)
+      : hash_code_(buf), combine_(nullptr) {}
 
   friend type_erased_hash_code hash_combine_range(
       type_erased_hash_code hash_code, unsigned char const* begin,
       unsigned char const* end) {
-    hash_code.wrapper_(begin, end);
+    if (hash_code.combine_ == nullptr) {
+      static_cast<buffer*>(hash_code.hash_code_)->append(begin, end);
+    } else {
+      hash_code.combine_(hash_code.hash_code_, begin, end);
+    }
+    return hash_code;
+  }
+
+ private:
+  // The wrapped HashCode, or the buffer if combine_ is null.
+  void* hash_code_;
+  combine_fn combine_;
+};
+
+// Returns hash_value(hash_code, value), for a type T whose hash_value() is
+// defined out of line, as a template that is explicitly instantiated for
+// type_erased_hash_code and for each of DirectHashCodes. If HashCode is one
+// of DirectHashCodes, its instantiation is called directly; otherwise the
+// call goes through a type_erased_hash_code. For example, pimpl.h lists
+// hashing::farmhash, the default HashCode, so that std_::hash doesn't pay
+// for type erasure.
+template <typename... DirectHashCodes, typename HashCode, typename T>
+HashCode hash_value_out_of_line(HashCode hash_code, const T& value) {
+  if constexpr ((std::is_same<HashCode, DirectHashCodes>::value || ...)) {
+    return hash_value(std::move(hash_code), value);
+  } else {
+    {
+      // Flushes on destruction.
+      type_erased_hash_code::buffer buffer(&hash_code);
+      hash_value(type_erased_hash_code(&buffer), value);
+    }
     return hash_code;
   }
+}
+
+// A list of DirectHashCodes for hash_value_out_of_line(), so that a type's
+// hash_value() and its std_::is_hashed_via_type_erasure specialization can
+// be derived from the same list:
+//
+//   using direct = hashing::direct_hash_codes<hashing::farmhash>;
+//   ... return direct::hash_value_out_of_line(std::move(hash_code), impl);
+//   ... : integral_constant<bool, !direct::contains<HashCode>()> {};
+template <typename... DirectHashCodes>
+struct direct_hash_codes {
+  template <typename HashCode>
+  static constexpr bool contains() {
+    return (std::is_same<HashCode, DirectHashCodes>::value || ...);
+  }
+
+  template <typename HashCode, typename T>
+  static HashCode hash_value_out_of_line(HashCode hash_code, const T& value) {
+    return hashing::hash_value_out_of_line<DirectHashCodes...>(
+        std::move(hash_code), value);
+  }
 };
 
 // Various optimizations of these overloads are possible, but omitted for
@@ -75,4 +190,22 @@ type_erased_hash_code hash_combine_range(
 
 }  // namespace hashing
 
+namespace std_ {
+namespace detail {
+
+// A type_erased_hash_code can't be created without the HashCode it wraps,
+// whose type it doesn't know, so the elements of unordered containers are
+// hashed with std_::hash instead.
+template <>
+struct unordered_element_hasher<hashing::type_erased_hash_code> {
+  template <typename T>
+  static size_t hash(const hashing::type_erased_hash_code& /*code*/,
+                     const T& value) {
+    return std_::hash<T>{}(value);
+  }
+};
+
+}  // namespace detail
+}  // namespace std_
+
 #endif // HASHING_DEMO_TYPE_ERASED_HASH_CODE_H
@@ -0,0 +1,197 @@
+// Copyright 2015 Google Inc. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef HASHING_DEMO_TYPE_INVARIANT_FARMHASH_H
+#define HASHING_DEMO_TYPE_INVARIANT_FARMHASH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "farmhash.h"
+#include "std_impl.h"
+
+namespace hashing {
+
+// Type-invariant HashCode built on farmhash. Rather than give up the
+// fast path for uniquely-represented types altogether, as
+// type_invariant_fnv1a does, it converts each value to a canonical
+// representation that doesn't depend on the value's type, and hashes
+// that:
+//
+// - char is a single byte, so strings hash as their bytes regardless of
+//   the string type.
+// - Other integers, including signed char and unsigned char (int8_t and
+//   uint8_t), and enums, are sign- or zero-extended to 64 bits, so e.g.
+//   int8_t(5), int(5), long(5) and unsigned(5) hash equally, which allows
+//   heterogeneous lookup across integer key types.
+// - Floating-point values are converted to double, with -0.0 mapped to 0.
+//
+// Everything else is hashed via hash_value(), so that types like
+// InternedString in type-invariant_test.cc can override their usual
+// representation. Contiguous ranges whose elements are already canonical
+// (char and 64-bit integers) are passed to farmhash in bulk,
+// and contiguous ranges of narrower integers are widened in blocks.
+//
+// Values hashed through type_erased_hash_code, such as Pimpl, are seen as
+// raw bytes, so they are hashed consistently but not type-invariantly.
+class type_invariant_farmhash {
+  farmhash code_;
+
+ public:
+  using result_type = size_t;
+  using state_type = farmhash::state_type;
+
+  explicit type_invariant_farmhash(state_type* state) : code_(state) {}
+
+  // Move only
+  type_invariant_farmhash(type_invariant_farmhash&&) = default;
+  type_invariant_farmhash& operator=(type_invariant_farmhash&&) = default;
+
+  template <typename T, typename... Ts>
+  friend type_invariant_farmhash hash_combine(
+      type_invariant_farmhash hash_code, const T& value,
+      const Ts&... values) {
+    return hash_combine(combine_one(std::move(hash_code), value), values...);
+  }
+
+  friend type_invariant_farmhash hash_combine(
+      type_invariant_farmhash hash_code) {
+    return hash_code;
+  }
+
+  template <typename InputIterator>
+  friend type_invariant_farmhash hash_combine_range(
+      type_invariant_farmhash hash_code, InputIterator begin,
+      InputIterator end) {
+    using T = std::remove_cv_t<
+        typename std::iterator_traits<InputIterator>::value_type>;
+    if constexpr (std_::is_contiguous_iterator<InputIterator>::value &&
+                  is_canonical<T>()) {
+      const auto pointers =
+          std_::detail::contiguous_range_pointers(begin, end);
+      const auto* begin_ptr =
+          reinterpret_cast<const unsigned char*>(pointers.first);
+      const auto* end_ptr =
+          reinterpret_cast<const unsigned char*>(pointers.second);
+      return hash_combine_range(std::move(hash_code), begin_ptr, end_ptr);
+    } else if constexpr (std_::is_contiguous_iterator<InputIterator>::value &&
+                         is_widened_integer<T>()) {
+      const auto pointers =
+          std_::detail::contiguous_range_pointers(begin, end);
+      const T* p = pointers.first;
+      const T* const last = pointers.second;
+      uint64_t block[32];
+      while (p != last) {
+        const size_t n = std::min<size_t>(32, last - p);
+        for (size_t i = 0; i < n; ++i) block[i] = canonicalize(p[i]);
+        p += n;
+        const auto* bytes = reinterpret_cast<const unsigned char*>(block);
+        hash_code = hash_combine_range(std::move(hash_code), bytes,
+                                       bytes + n * sizeof(uint64_t));
+      }
+      return hash_code;
+    } else {
+      for (; begin != end; ++begin) {
+        hash_code = combine_one(std::move(hash_code), *begin);
+      }
+      return hash_code;
+    }
+  }
+
+  friend type_invariant_farmhash hash_combine_range(
+      type_invariant_farmhash hash_code, const unsigned char* begin,
+      const unsigned char* end) {
+    hash_code.code_ =
+        hash_combine_range(std::move(hash_code.code_), begin, end);
+    return hash_code;
+  }
+
+  explicit operator result_type() && {
+    return result_type(std::move(code_));
+  }
+
+ private:
+  template <typename T>
+  static constexpr bool is_character() {
+    return std::is_same<T, char>::value;
+  }
+
+  template <typename T>
+  static constexpr bool is_widened_integer() {
+    return std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+           !is_character<T>();
+  }
+
+  // Whether T's object representation is its canonical representation.
+  template <typename T>
+  static constexpr bool is_canonical() {
+    return is_character<T>() ||
+           (is_widened_integer<T>() && sizeof(T) == sizeof(uint64_t));
+  }
+
+  template <typename Int>
+  static uint64_t canonicalize(Int value) {
+    return std::is_signed<Int>::value
+               ? static_cast<uint64_t>(static_cast<int64_t>(value))
+               : static_cast<uint64_t>(value);
+  }
+
+  template <typename T>
+  static type_invariant_farmhash mix_bytes(type_invariant_farmhash hash_code,
+                                           const T& value) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+    return hash_combine_range(std::move(hash_code), bytes,
+                              bytes + sizeof(value));
+  }
+
+  template <typename T>
+  static type_invariant_farmhash combine_one(
+      type_invariant_farmhash hash_code, const T& value) {
+    if constexpr (is_character<T>()) {
+      return mix_bytes(std::move(hash_code), value);
+    } else if constexpr (is_widened_integer<T>()) {
+      return mix_bytes(std::move(hash_code), canonicalize(value));
+    } else if constexpr (std::is_enum<T>::value) {
+      return combine_one(std::move(hash_code),
+                         static_cast<std::underlying_type_t<T>>(value));
+    } else if constexpr (std::is_floating_point<T>::value) {
+      const double canonical = value == 0 ? 0.0 : static_cast<double>(value);
+      return mix_bytes(std::move(hash_code), canonical);
+    } else {
+      using std_::hash_value;
+      return hash_value(std::move(hash_code), value);
+    }
+  }
+};
+
+// Hash functor using type_invariant_farmhash. Since equal values of
+// different types have equal hashes, it's transparent, for containers that
+// support heterogeneous lookup.
+struct type_invariant_hash {
+  using is_transparent = void;
+
+  template <typename T>
+  size_t operator()(const T& value) const {
+    type_invariant_farmhash::state_type state;
+    return size_t(hash_combine(type_invariant_farmhash(&state), value));
+  }
+};
+
+}  // namespace hashing
+
+#endif  // HASHING_DEMO_TYPE_INVARIANT_FARMHASH_H